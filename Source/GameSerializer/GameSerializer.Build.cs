@@ -38,6 +38,7 @@ public class GameSerializer : ModuleRules
 				"Engine",
 				"Slate",
 				"SlateCore",
+				"DeveloperSettings",
 
 				"Json",
 				"JsonUtilities",
@@ -2,6 +2,8 @@
 
 #include "GameSerializer.h"
 
+#include "GameSerializerClassCache.h"
+#include "GameSerializerComponentInstancing.h"
 #include "GameSerializerExtendData.h"
 
 #define LOCTEXT_NAMESPACE "FGameSerializerModule"
@@ -11,6 +13,11 @@ void FGameSerializerModule::StartupModule()
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
 
 	GameSerializerExtendDataFactory::RegisterFactory<FActorGameSerializerExtendDataFactory>(AActor::StaticClass());
+	GameSerializerClassCache::Startup();
+	// 类型重新实例化后工厂的查找结果也需要重新计算
+	GameSerializerClassCache::OnFlushed().AddStatic(&GameSerializerExtendDataFactory::InvalidateResolvedFactories);
+	GameSerializerClassCache::OnFlushed().AddStatic(&GameSerializerRepNotifyTable::Flush);
+	GameSerializerClassCache::OnFlushed().AddStatic(&GameSerializerComponentInstancing::Flush);
 }
 
 void FGameSerializerModule::ShutdownModule()
@@ -18,6 +25,7 @@ void FGameSerializerModule::ShutdownModule()
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
 	
+	GameSerializerClassCache::Shutdown();
 }
 
 #undef LOCTEXT_NAMESPACE
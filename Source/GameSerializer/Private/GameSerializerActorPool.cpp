@@ -0,0 +1,266 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameSerializerActorPool.h"
+#include <Engine/Level.h>
+#include <Engine/World.h>
+#include <GameFramework/Actor.h>
+#include <Components/SceneComponent.h>
+#include <UObject/UObjectHash.h>
+
+#include "GameSerializer_Log.h"
+#include "GameSerializerSettings.h"
+
+namespace GameSerializerActorPool
+{
+	constexpr ERenameFlags RenameFlags = REN_DontCreateRedirectors | REN_ForceNoResetLoaders | REN_NonTransactional | REN_DoNotDirty;
+
+	// 只有不复制的Actor会被回收，直接修改关卡的Actor列表不需要处理网络标识
+	static void MoveActorToLevel(AActor* Actor, ULevel* Level, const FName& Name)
+	{
+		ULevel* OldLevel = Actor->GetLevel();
+		if (OldLevel != Level)
+		{
+			OldLevel->Actors.RemoveSingleSwap(Actor, false);
+		}
+		Actor->Rename(Name.IsNone() ? nullptr : *Name.ToString(), Level, RenameFlags);
+		if (OldLevel != Level)
+		{
+			Level->Actors.Add(Actor);
+		}
+	}
+
+	// 运行时添加的组件与子对象不属于原型，复用时会与读档重新实例化的同名子对象冲突
+	static void DestroyDynamicSubObjects(AActor* Actor)
+	{
+		TInlineComponentArray<UActorComponent*> Components(Actor);
+		for (UActorComponent* Component : Components)
+		{
+			if (Component->CreationMethod == EComponentCreationMethod::Instance)
+			{
+				Component->DestroyComponent();
+			}
+		}
+
+		TArray<UObject*> SubObjects;
+		GetObjectsWithOuter(Actor, SubObjects, false);
+		for (UActorComponent* Component : Actor->GetComponents())
+		{
+			GetObjectsWithOuter(Component, SubObjects, false);
+		}
+		for (UObject* SubObject : SubObjects)
+		{
+			if (IsValid(SubObject) == false || SubObject->IsA<UActorComponent>() || SubObject->IsDefaultSubobject())
+			{
+				continue;
+			}
+			SubObject->Rename(nullptr, GetTransientPackage(), RenameFlags);
+			SubObject->MarkAsGarbage();
+		}
+	}
+
+	// 非Transient的属性恢复为原型的值，包括运行时状态
+	// 对象引用可能指向原型自身的子对象，只恢复SaveGame的引用（读档时会被覆盖），其余保持不变
+	// 实例化的子对象引用与Tick函数不能从原型复制
+	static void ResetToArchetype(UObject* Object)
+	{
+		const UObject* Archetype = Object->GetArchetype();
+		UClass* Class = Object->GetClass();
+
+		TSet<const FProperty*> ReferenceProperties;
+		for (const FProperty* Property = Class->RefLink; Property; Property = Property->NextRef)
+		{
+			ReferenceProperties.Add(Property);
+		}
+
+		for (TFieldIterator<FProperty> It(Class); It; ++It)
+		{
+			const FProperty* Property = *It;
+			if (Property->HasAnyPropertyFlags(CPF_Transient | CPF_InstancedReference | CPF_ContainsInstancedReference))
+			{
+				continue;
+			}
+			if (ReferenceProperties.Contains(Property) && Property->HasAnyPropertyFlags(CPF_SaveGame) == false)
+			{
+				continue;
+			}
+			const FStructProperty* StructProperty = CastField<FStructProperty>(Property);
+			if (StructProperty && StructProperty->Struct->IsChildOf(FTickFunction::StaticStruct()))
+			{
+				continue;
+			}
+			Property->CopyCompleteValue_InContainer(Object, Archetype);
+		}
+
+		if (UActorComponent* Component = Cast<UActorComponent>(Object))
+		{
+			if (Component->IsRegistered())
+			{
+				Component->MarkRenderStateDirty();
+			}
+		}
+	}
+
+	// 激活时恢复为原型的状态
+	static void SetActorActive(AActor* Actor, bool bActive)
+	{
+		const AActor* Archetype = CastChecked<AActor>(Actor->GetArchetype());
+		Actor->SetActorHiddenInGame(bActive ? Archetype->IsHidden() : true);
+		Actor->SetActorEnableCollision(bActive ? Archetype->GetActorEnableCollision() : false);
+		Actor->SetActorTickEnabled(bActive && Actor->PrimaryActorTick.bStartWithTickEnabled);
+		for (UActorComponent* Component : Actor->GetComponents())
+		{
+			Component->SetComponentTickEnabled(bActive && Component->PrimaryComponentTick.bStartWithTickEnabled);
+		}
+	}
+}
+
+bool UGameSerializerActorPool::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return Super::ShouldCreateSubsystem(Outer) && GetDefault<UGameSerializerSettings>()->bUseActorPool;
+}
+
+bool UGameSerializerActorPool::DoesSupportWorldType(EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UGameSerializerActorPool::Deinitialize()
+{
+	PooledActors.Empty();
+	PooledClasses.Empty();
+	ParkedActors.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UGameSerializerActorPool::CanPool(const AActor* Actor) const
+{
+	// 只回收动态生成且不复制的Actor，预放置的Actor由关卡加载
+	if (IsValid(Actor) == false || Actor->HasAnyFlags(RF_WasLoaded) || Actor->IsNetStartupActor() || Actor->GetIsReplicated())
+	{
+		return false;
+	}
+	for (const UClass* Class = Actor->GetClass(); Class; Class = Class->GetSuperClass())
+	{
+		if (PooledClasses.Contains(Class))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+DECLARE_CYCLE_STAT(TEXT("ActorPool_ParkLevelActors"), STAT_ActorPool_ParkLevelActors, STATGROUP_GameSerializer);
+void UGameSerializerActorPool::ParkLevelActors(ULevel* Level)
+{
+	GameSerializerStatLog(STAT_ActorPool_ParkLevelActors);
+
+	const UGameSerializerSettings* Settings = GetDefault<UGameSerializerSettings>();
+	PooledClasses.Reset();
+	for (const TSoftClassPtr<AActor>& PooledActorClass : Settings->PooledActorClasses)
+	{
+		if (UClass* Class = PooledActorClass.Get())
+		{
+			if (Class->GetDefaultObject<AActor>()->GetIsReplicated())
+			{
+				UE_LOG(GameSerializer_Log, Warning, TEXT("复制的类型[%s]不支持回收"), *Class->GetName());
+				continue;
+			}
+			PooledClasses.Add(Class);
+		}
+	}
+	if (PooledClasses.Num() == 0)
+	{
+		return;
+	}
+
+	ULevel* PersistentLevel = GetWorld()->PersistentLevel;
+	if (Level == PersistentLevel)
+	{
+		return;
+	}
+
+	TArray<AActor*> ToParkActors;
+	for (AActor* Actor : Level->Actors)
+	{
+		if (CanPool(Actor))
+		{
+			ToParkActors.Add(Actor);
+		}
+	}
+
+	for (AActor* Actor : ToParkActors)
+	{
+		TArray<TWeakObjectPtr<AActor>>& ClassPool = PooledActors.FindOrAdd(Actor->GetClass());
+		if (ClassPool.Num() >= Settings->ActorPoolMaxPerClass)
+		{
+			continue;
+		}
+		Actor->SetOwner(nullptr);
+		Actor->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+		TArray<AActor*> AttachedActors;
+		Actor->GetAttachedActors(AttachedActors);
+		for (AActor* AttachedActor : AttachedActors)
+		{
+			AttachedActor->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+		}
+		GameSerializerActorPool::DestroyDynamicSubObjects(Actor);
+		GameSerializerActorPool::SetActorActive(Actor, false);
+		GameSerializerActorPool::MoveActorToLevel(Actor, PersistentLevel, NAME_None);
+		ClassPool.Add(Actor);
+		ParkedActors.Add(Actor);
+	}
+}
+
+AActor* UGameSerializerActorPool::Reuse(UClass* Class, ULevel* Level, const FName& Name, const FTransform& Transform)
+{
+	TArray<TWeakObjectPtr<AActor>>* ClassPool = PooledActors.Find(Class);
+	if (ClassPool == nullptr)
+	{
+		return nullptr;
+	}
+
+	while (ClassPool->Num() > 0)
+	{
+		AActor* Actor = ClassPool->Pop(false).Get();
+		if (IsValid(Actor) == false)
+		{
+			continue;
+		}
+
+		ParkedActors.Remove(Actor);
+		GameSerializerActorPool::MoveActorToLevel(Actor, Level, Name);
+		GameSerializerActorPool::ResetToArchetype(Actor);
+		for (UActorComponent* Component : Actor->GetComponents())
+		{
+			GameSerializerActorPool::ResetToArchetype(Component);
+		}
+		Actor->SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+		GameSerializerActorPool::SetActorActive(Actor, true);
+		return Actor;
+	}
+	return nullptr;
+}
+
+bool UGameSerializerActorPool::IsParked(const AActor* Actor)
+{
+	// 回收的Actor只会在持久关卡中
+	const UWorld* World = Actor->GetWorld();
+	if (World == nullptr || Actor->GetLevel() != World->PersistentLevel)
+	{
+		return false;
+	}
+	const UGameSerializerActorPool* ActorPool = World->GetSubsystem<UGameSerializerActorPool>();
+	return ActorPool && ActorPool->ParkedActors.Contains(Actor);
+}
+
+int32 UGameSerializerActorPool::GetPooledNum() const
+{
+	int32 Num = 0;
+	for (const TPair<TWeakObjectPtr<UClass>, TArray<TWeakObjectPtr<AActor>>>& Pair : PooledActors)
+	{
+		Num += Pair.Value.Num();
+	}
+	return Num;
+}
@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameSerializerClassCache.h"
+#include <UObject/UObjectGlobals.h>
+
+#include "GameSerializerInterface.h"
+
+namespace GameSerializerClassCache
+{
+	TMap<const UClass*, FGameSerializerClassCapabilities> CapabilitiesMap;
+	FOnFlushed OnFlushedDelegate;
+	FDelegateHandle OnObjectsReplaced_DelegateHandle;
+	FDelegateHandle ReloadComplete_DelegateHandle;
+
+	static int32 FindNativeInterfaceOffset(const UClass* Class, const UClass* InterfaceClass)
+	{
+		for (const UClass* CurrentClass = Class; CurrentClass; CurrentClass = CurrentClass->GetSuperClass())
+		{
+			for (const FImplementedInterface& ImplementedInterface : CurrentClass->Interfaces)
+			{
+				if (ImplementedInterface.bImplementedByK2 == false && ImplementedInterface.Class && ImplementedInterface.Class->IsChildOf(InterfaceClass))
+				{
+					return ImplementedInterface.PointerOffset;
+				}
+			}
+		}
+		return INDEX_NONE;
+	}
+
+	static bool IsOverriddenByScript(const UClass* Class, const FName& FunctionName)
+	{
+		const UFunction* Function = Class->FindFunctionByName(FunctionName);
+		return Function && Function->HasAnyFunctionFlags(FUNC_Native) == false;
+	}
+
+	static void BuildCapabilities(const UClass* Class, FGameSerializerClassCapabilities& Capabilities)
+	{
+		Capabilities = FGameSerializerClassCapabilities();
+		Capabilities.Class = Class;
+		Capabilities.bGameSerializerInterface = Class->ImplementsInterface(UGameSerializerInterface::StaticClass());
+		Capabilities.bActorInterface = Class->ImplementsInterface(UActorGameSerializerInterface::StaticClass());
+		Capabilities.bComponentInterface = Class->ImplementsInterface(UComponentGameSerializerInterface::StaticClass());
+
+		if (Capabilities.bGameSerializerInterface)
+		{
+			Capabilities.GameSerializerInterfaceOffset = FindNativeInterfaceOffset(Class, UGameSerializerInterface::StaticClass());
+		}
+		if (Capabilities.bActorInterface)
+		{
+			const int32 ActorInterfaceOffset = FindNativeInterfaceOffset(Class, UActorGameSerializerInterface::StaticClass());
+			Capabilities.ActorInterfaceOffset = ActorInterfaceOffset;
+			if (ActorInterfaceOffset != INDEX_NONE)
+			{
+				Capabilities.bNativeCanGameSerializedInLevel = IsOverriddenByScript(Class, GET_FUNCTION_NAME_CHECKED(IActorGameSerializerInterface, CanGameSerializedInLevel)) == false;
+				Capabilities.bNativeGetGameSerializedOwner = IsOverriddenByScript(Class, GET_FUNCTION_NAME_CHECKED(IActorGameSerializerInterface, GetGameSerializedOwner)) == false;
+				Capabilities.bNativeGetGameSerializePriority = IsOverriddenByScript(Class, GET_FUNCTION_NAME_CHECKED(IActorGameSerializerInterface, GetGameSerializePriority)) == false;
+			}
+		}
+	}
+
+	const FGameSerializerClassCapabilities& Get(const UClass* Class)
+	{
+		check(IsInGameThread());
+		FGameSerializerClassCapabilities& Capabilities = CapabilitiesMap.FindOrAdd(Class);
+		// 类型被回收后地址可能被新的类型复用
+		if (Capabilities.Class.Get() != Class)
+		{
+			BuildCapabilities(Class, Capabilities);
+		}
+		return Capabilities;
+	}
+
+	void Flush()
+	{
+		CapabilitiesMap.Empty();
+		OnFlushedDelegate.Broadcast();
+	}
+
+	FOnFlushed& OnFlushed()
+	{
+		return OnFlushedDelegate;
+	}
+
+	void Startup()
+	{
+#if WITH_EDITOR
+		OnObjectsReplaced_DelegateHandle = FCoreUObjectDelegates::OnObjectsReplaced.AddLambda([](const TMap<UObject*, UObject*>&)
+		{
+			Flush();
+		});
+#endif
+		ReloadComplete_DelegateHandle = FCoreUObjectDelegates::ReloadCompleteDelegate.AddLambda([](EReloadCompleteReason)
+		{
+			Flush();
+		});
+	}
+
+	void Shutdown()
+	{
+#if WITH_EDITOR
+		FCoreUObjectDelegates::OnObjectsReplaced.Remove(OnObjectsReplaced_DelegateHandle);
+#endif
+		FCoreUObjectDelegates::ReloadCompleteDelegate.Remove(ReloadComplete_DelegateHandle);
+		// 依赖类型信息的缓存需要在UObject销毁前释放，不能留到静态析构
+		Flush();
+		// 模块重新加载时会再次绑定
+		OnFlushedDelegate.Clear();
+	}
+}
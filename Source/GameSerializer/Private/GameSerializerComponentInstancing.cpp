@@ -0,0 +1,202 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameSerializerComponentInstancing.h"
+#include <Engine/BlueprintGeneratedClass.h>
+#include <Engine/SimpleConstructionScript.h>
+#include <Engine/SCS_Node.h>
+
+#include "GameSerializer_Log.h"
+
+namespace GameSerializerComponentInstancing
+{
+	struct FNodePlan
+	{
+		FName VariableName;
+		// 有合法的Cook数据时走快速路径，否则通过模板复制
+		const FBlueprintCookedComponentInstancingData* TemplateData = nullptr;
+		UActorComponent* Template = nullptr;
+		FName AttachToName;
+		// 子节点挂接的场景组件在计划中的下标，INDEX_NONE时作为根组件
+		int32 AttachParentIdx = INDEX_NONE;
+		// 子树的结束下标，组件创建失败时跳过整个子树
+		int32 SubtreeEndIdx = INDEX_NONE;
+		// 组件需要赋值的属性，类型不符时为空
+		FObjectPropertyBase* Property = nullptr;
+	};
+
+	struct FInstancingPlan
+	{
+		TWeakObjectPtr<UBlueprintGeneratedClass> Class;
+		// 按深度优先排列，父节点总在子节点之前
+		TArray<FNodePlan> Nodes;
+	};
+
+	TMap<const UBlueprintGeneratedClass*, FInstancingPlan> Plans;
+
+	static void BuildNodePlan(FInstancingPlan& Plan, UBlueprintGeneratedClass* ActualBPGC, USCS_Node* Node, int32 AttachParentIdx)
+	{
+		const int32 NodeIdx = Plan.Nodes.AddDefaulted();
+		FNodePlan& NodePlan = Plan.Nodes[NodeIdx];
+		NodePlan.VariableName = Node->GetVariableName();
+		NodePlan.AttachToName = Node->AttachToName;
+		NodePlan.AttachParentIdx = AttachParentIdx;
+
+		const UClass* ComponentClass = nullptr;
+		const FBlueprintCookedComponentInstancingData* TemplateData = ActualBPGC->UseFastPathComponentInstancing() ? Node->GetActualComponentTemplateData(ActualBPGC) : nullptr;
+		if (TemplateData && TemplateData->bHasValidCookedData
+			&& ensureMsgf(TemplateData->ComponentTemplateClass != nullptr, TEXT("SCS fast path (%s.%s): Cooked data is valid, but runtime support data is not initialized. Using the slow path instead."), *ActualBPGC->GetName(), *NodePlan.VariableName.ToString()))
+		{
+			NodePlan.TemplateData = TemplateData;
+			ComponentClass = TemplateData->ComponentTemplateClass;
+		}
+		else if (UActorComponent* Template = Node->GetActualComponentTemplate(ActualBPGC))
+		{
+			NodePlan.Template = Template;
+			ComponentClass = Template->GetClass();
+		}
+
+		if (NodePlan.VariableName != NAME_None && ComponentClass)
+		{
+			if (FObjectPropertyBase* Property = FindFProperty<FObjectPropertyBase>(ActualBPGC, NodePlan.VariableName))
+			{
+				// If it is null we don't really know what's going on, but make it behave as it did before the bug fix
+				if (Property->PropertyClass == nullptr || ComponentClass->IsChildOf(Property->PropertyClass))
+				{
+					NodePlan.Property = Property;
+				}
+				else
+				{
+					UE_LOG(LogBlueprint, Log, TEXT("ExecuteNodeOnActor: Property '%s' on '%s' is of type '%s'. Could not assign '%s' to it."), *NodePlan.VariableName.ToString(), *ActualBPGC->GetName(), *Property->PropertyClass->GetName(), *ComponentClass->GetName());
+				}
+			}
+			else
+			{
+				UE_LOG(LogBlueprint, Log, TEXT("ExecuteNodeOnActor: Couldn't find property '%s' on '%s'"), *NodePlan.VariableName.ToString(), *ActualBPGC->GetName());
+			}
+		}
+
+		// Determine the parent component for our children (it's still our parent if we're a non-scene component)
+		const int32 ChildAttachParentIdx = ComponentClass && ComponentClass->IsChildOf<USceneComponent>() ? NodeIdx : AttachParentIdx;
+		for (USCS_Node* ChildNode : Node->ChildNodes)
+		{
+			check(ChildNode != nullptr);
+			BuildNodePlan(Plan, ActualBPGC, ChildNode, ChildAttachParentIdx);
+		}
+		Plan.Nodes[NodeIdx].SubtreeEndIdx = Plan.Nodes.Num();
+	}
+
+	static void BuildPlan(FInstancingPlan& Plan, UBlueprintGeneratedClass* ActualBPGC)
+	{
+		Plan.Class = ActualBPGC;
+		Plan.Nodes.Reset();
+
+		TArray<const UBlueprintGeneratedClass*> ParentBPClassStack;
+		const bool bErrorFree = UBlueprintGeneratedClass::GetGeneratedClassesHierarchy(ActualBPGC, ParentBPClassStack);
+		if (bErrorFree == false)
+		{
+			return;
+		}
+		for (int32 i = ParentBPClassStack.Num() - 1; i >= 0; i--)
+		{
+			const UBlueprintGeneratedClass* CurrentBPGClass = ParentBPClassStack[i];
+			check(CurrentBPGClass);
+			if (const USimpleConstructionScript* SCS = CurrentBPGClass->SimpleConstructionScript)
+			{
+				for (USCS_Node* Node : SCS->GetRootNodes())
+				{
+					BuildNodePlan(Plan, ActualBPGC, Node, INDEX_NONE);
+				}
+			}
+		}
+	}
+
+	static const FInstancingPlan& GetPlan(UBlueprintGeneratedClass* ActualBPGC)
+	{
+		check(IsInGameThread());
+		FInstancingPlan& Plan = Plans.FindOrAdd(ActualBPGC);
+		// 类型被回收后地址可能被新的类型复用
+		if (Plan.Class.Get() != ActualBPGC)
+		{
+			BuildPlan(Plan, ActualBPGC);
+		}
+		return Plan;
+	}
+
+	DECLARE_CYCLE_STAT(TEXT("ComponentInstancing_InstanceComponents"), STAT_ComponentInstancing_InstanceComponents, STATGROUP_GameSerializer);
+	void InstanceComponents(UBlueprintGeneratedClass* Class, AActor* Actor, const FTransform& RootTransform)
+	{
+		GameSerializerStatLog(STAT_ComponentInstancing_InstanceComponents);
+
+		check(Actor != nullptr);
+		const FInstancingPlan& Plan = GetPlan(Class);
+
+		TArray<UActorComponent*, TInlineAllocator<16>> Components;
+		Components.SetNumZeroed(Plan.Nodes.Num());
+		for (int32 NodeIdx = 0; NodeIdx < Plan.Nodes.Num();)
+		{
+			const FNodePlan& NodePlan = Plan.Nodes[NodeIdx];
+
+			// Create a new component instance based on the template
+			UActorComponent* NewActorComp = nullptr;
+			if (NodePlan.TemplateData)
+			{
+				NewActorComp = Actor->CreateComponentFromTemplateData(NodePlan.TemplateData, NodePlan.VariableName);
+			}
+			else if (NodePlan.Template)
+			{
+				NewActorComp = Actor->CreateComponentFromTemplate(NodePlan.Template, NodePlan.VariableName);
+			}
+
+			if (NewActorComp == nullptr)
+			{
+				NodeIdx = NodePlan.SubtreeEndIdx;
+				continue;
+			}
+			Components[NodeIdx] = NewActorComp;
+
+			NewActorComp->CreationMethod = EComponentCreationMethod::SimpleConstructionScript;
+
+			// SCS created components are net addressable
+			NewActorComp->SetNetAddressable();
+
+			if (!NewActorComp->HasBeenCreated())
+			{
+				// Call function to notify component it has been created
+				NewActorComp->OnComponentCreated();
+			}
+
+			// Special handling for scene components
+			if (USceneComponent* NewSceneComp = Cast<USceneComponent>(NewActorComp))
+			{
+				USceneComponent* ParentComponent = NodePlan.AttachParentIdx != INDEX_NONE ? CastChecked<USceneComponent>(Components[NodePlan.AttachParentIdx]) : nullptr;
+				// If NULL is passed in, we are the root, so set transform and assign as RootComponent on Actor, similarly if the 
+				// NewSceneComp is the ParentComponent then we are the root component. This happens when the root component is recycled
+				// by StaticAllocateObject.
+				if (ParentComponent == nullptr || ParentComponent->IsPendingKill() || ParentComponent == NewSceneComp)
+				{
+					NewSceneComp->SetWorldTransform(RootTransform);
+					Actor->SetRootComponent(NewSceneComp);
+				}
+				// Otherwise, attach to parent component passed in
+				else
+				{
+					NewSceneComp->SetupAttachment(ParentComponent, NodePlan.AttachToName);
+				}
+			}
+
+			// If we want to save this to a property, do it here
+			if (NodePlan.Property)
+			{
+				NodePlan.Property->SetObjectPropertyValue_InContainer(Actor, NewActorComp);
+			}
+
+			++NodeIdx;
+		}
+	}
+
+	void Flush()
+	{
+		Plans.Empty();
+	}
+}
@@ -5,31 +5,168 @@
 #include <JsonObjectWrapper.h>
 #include <Internationalization/Culture.h>
 #include <Misc/ScopeExit.h>
+#include <Algo/BinarySearch.h>
+#include <UObject/UObjectArray.h>
+#include <UObject/UObjectHash.h>
 #include <Engine/SimpleConstructionScript.h>
-#include <Engine/SCS_Node.h>
 #include <Engine/LevelScriptActor.h>
 #include <Dom/JsonObject.h>
 #include <Policies/CondensedJsonPrintPolicy.h>
 #include <Serialization/JsonSerializer.h>
 #include <Serialization/JsonWriter.h>
-
+#include <Serialization/MemoryWriter.h>
+#include <Serialization/MemoryReader.h>
+#include <Serialization/ObjectAndNameAsStringProxyArchive.h>
+#include <Serialization/CustomVersion.h>
+#include <UObject/ObjectVersion.h>
+#include <Misc/Base64.h>
+
+#include "GameSerializerActorPool.h"
+#include "GameSerializerClassCache.h"
+#include "GameSerializerComponentInstancing.h"
+#include "GameSerializerExtendData.h"
+#include "GameSerializerIdentity.h"
 #include "GameSerializerInterface.h"
+#include "GameSerializerSettings.h"
 #include "GameSerializer_Log.h"
 
 namespace CustomJsonConverter
 {
-	DECLARE_DELEGATE_RetVal_FourParams(TSharedPtr<FJsonValue>, FCustomExportCallback, FProperty* /* Property */, const void* /* Value */, const void* /*Default*/, bool& /*bSameValue*/);
+	// 结构体原生的二进制序列化，数据以Base64储存在Json对象中
+	namespace BinaryStruct
+	{
+		constexpr TCHAR BinaryFieldName[] = TEXT("__Binary");
+		constexpr TCHAR UE4VersionFieldName[] = TEXT("__UE4Ver");
+		constexpr TCHAR UE5VersionFieldName[] = TEXT("__UE5Ver");
+		constexpr TCHAR LicenseeVersionFieldName[] = TEXT("__LicenseeVer");
+		constexpr TCHAR CustomVersionsFieldName[] = TEXT("__CustomVer");
+
+		// NetSerialize是网络协议格式，依赖PackageMap，不用于存档
+		static bool HasBinarySerializer(const UScriptStruct::ICppStructOps* CppStructOps)
+		{
+			return CppStructOps && CppStructOps->HasSerializer();
+		}
+
+		static bool CanExport(const UScriptStruct* Struct)
+		{
+			return HasBinarySerializer(Struct->GetCppStructOps()) && GetDefault<UGameSerializerSettings>()->IsBinarySerializeStruct(Struct);
+		}
+
+		static TSharedPtr<FJsonValue> Export(const UScriptStruct* Struct, const void* Value)
+		{
+			UScriptStruct::ICppStructOps* CppStructOps = Struct->GetCppStructOps();
+			TArray<uint8> Bytes;
+			FMemoryWriter MemoryWriter(Bytes);
+			// 对象引用按路径储存
+			FObjectAndNameAsStringProxyArchive Ar(MemoryWriter, false);
+			if (CppStructOps->Serialize(Ar, const_cast<void*>(Value)) == false)
+			{
+				return nullptr;
+			}
+
+			const TSharedRef<FJsonObject> Out = MakeShared<FJsonObject>();
+			Out->SetStringField(BinaryFieldName, FBase64::Encode(Bytes));
+			// Serialize可能按版本分支，记录写入时的版本，引擎或插件升级后按旧版本读取
+			const FPackageFileVersion UEVersion = Ar.UEVer();
+			Out->SetNumberField(UE4VersionFieldName, UEVersion.FileVersionUE4);
+			Out->SetNumberField(UE5VersionFieldName, UEVersion.FileVersionUE5);
+			Out->SetNumberField(LicenseeVersionFieldName, Ar.LicenseeUEVer());
+			const FCustomVersionArray& CustomVersions = Ar.GetCustomVersions().GetAllVersions();
+			if (CustomVersions.Num() > 0)
+			{
+				const TSharedRef<FJsonObject> CustomVersionsJsonObject = MakeShared<FJsonObject>();
+				for (const FCustomVersion& CustomVersion : CustomVersions)
+				{
+					CustomVersionsJsonObject->SetNumberField(CustomVersion.Key.ToString(EGuidFormats::Digits), CustomVersion.Version);
+				}
+				Out->SetObjectField(CustomVersionsFieldName, CustomVersionsJsonObject);
+			}
+			return MakeShared<FJsonValueObject>(Out);
+		}
+
+		// 不是二进制数据时返回false，由调用方按其他格式读取
+		static bool TryImport(const UScriptStruct* Struct, const FJsonObject& JsonObject, void* OutValue, bool& bSucceed)
+		{
+			UScriptStruct::ICppStructOps* CppStructOps = Struct->GetCppStructOps();
+			if (HasBinarySerializer(CppStructOps) == false)
+			{
+				return false;
+			}
+
+			FString Base64String;
+			if (JsonObject.TryGetStringField(BinaryFieldName, Base64String) == false)
+			{
+				return false;
+			}
+
+			TArray<uint8> Bytes;
+			bSucceed = FBase64::Decode(Base64String, Bytes);
+			if (bSucceed)
+			{
+				FMemoryReader MemoryReader(Bytes);
+				// 没有版本记录时按当前版本读取
+				int32 UE4Version, UE5Version, LicenseeVersion;
+				if (JsonObject.TryGetNumberField(UE4VersionFieldName, UE4Version) && JsonObject.TryGetNumberField(UE5VersionFieldName, UE5Version))
+				{
+					MemoryReader.SetUEVer(FPackageFileVersion(UE4Version, static_cast<EUnrealEngineObjectUE5Version>(UE5Version)));
+				}
+				if (JsonObject.TryGetNumberField(LicenseeVersionFieldName, LicenseeVersion))
+				{
+					MemoryReader.SetLicenseeUEVer(LicenseeVersion);
+				}
+				const TSharedPtr<FJsonObject>* CustomVersionsJsonObject;
+				if (JsonObject.TryGetObjectField(CustomVersionsFieldName, CustomVersionsJsonObject))
+				{
+					FCustomVersionContainer CustomVersions;
+					for (const TPair<FString, TSharedPtr<FJsonValue>>& Pair : (*CustomVersionsJsonObject)->Values)
+					{
+						FGuid Key;
+						if (FGuid::Parse(Pair.Key, Key))
+						{
+							CustomVersions.SetVersion(Key, static_cast<int32>(Pair.Value->AsNumber()), NAME_None);
+						}
+					}
+					MemoryReader.SetCustomVersions(CustomVersions);
+				}
+				FObjectAndNameAsStringProxyArchive Ar(MemoryReader, true);
+				bSucceed = CppStructOps->Serialize(Ar, OutValue) && Ar.IsError() == false;
+			}
+			return true;
+		}
+	}
 
-	struct StructToJson
+	// TPolicy::ExportCustomValue(Property, Value, DefaultValue, bSameValue) 在类型判断前调用，返回无效值时走默认转换
+	// 策略在编译期展开，叶子属性不再经过委托调用
+	template<typename TPolicy>
+	struct TStructToJson
 	{
-		static TSharedPtr<FJsonValue> ConvertScalarFPropertyToJsonValue(FProperty* Property, const void* Value, const void* DefaultValue, bool& bSameValue, int64 CheckFlags, int64 SkipFlags, const FCustomExportCallback& ExportCb)
+		// 集合与映射的元素按自身的导出文本排序，对象按路径名排序，与哈希顺序以及导出时分配的序号无关
+		template<typename TIsValidIndex, typename TGetPtr>
+		static TArray<TPair<FString, int32>> SortElements(const FProperty* ElementProperty, int32 Num, TIsValidIndex IsValidIndex, TGetPtr GetPtr)
+		{
+			TArray<TPair<FString, int32>> SortedElements;
+			SortedElements.Reserve(Num);
+			for (int32 i = 0, n = Num; n; ++i)
+			{
+				if (IsValidIndex(i))
+				{
+					FString SortKey;
+					ElementProperty->ExportTextItem(SortKey, GetPtr(i), nullptr, nullptr, PPF_None);
+					SortedElements.Emplace(MoveTemp(SortKey), i);
+					--n;
+				}
+			}
+			SortedElements.StableSort([](const TPair<FString, int32>& LHS, const TPair<FString, int32>& RHS) { return LHS.Key < RHS.Key; });
+			return SortedElements;
+		}
+
+		static TSharedPtr<FJsonValue> ConvertScalarFPropertyToJsonValue(FProperty* Property, const void* Value, const void* DefaultValue, bool& bSameValue, int64 CheckFlags, int64 SkipFlags, TPolicy& Policy)
 		{
 			bSameValue = false;
 			
-			// See if there's a custom export callback first, so it can override default behavior
-			if (ExportCb.IsBound())
+			// See if there's a custom export first, so it can override default behavior
 			{
-				TSharedPtr<FJsonValue> CustomValue = ExportCb.Execute(Property, Value, DefaultValue, bSameValue);
+				TSharedPtr<FJsonValue> CustomValue = Policy.ExportCustomValue(Property, Value, DefaultValue, bSameValue);
 				if (CustomValue.IsValid())
 				{
 					return CustomValue;
@@ -140,7 +277,7 @@ namespace CustomJsonConverter
 				{
 					const bool IsValidDefaultValueIdx = DefaultValue ? DefaultValueHelper->IsValidIndex(i) : false;
 					bool bElementSameValue;
-					TSharedPtr<FJsonValue> Elem = UPropertyToJsonValue(ArrayProperty->Inner, Helper.GetRawPtr(i), IsValidDefaultValueIdx ? DefaultValueHelper->GetRawPtr(i) : nullptr, bElementSameValue, CheckFlags & (~CPF_ParmFlags), SkipFlags, ExportCb);
+					TSharedPtr<FJsonValue> Elem = UPropertyToJsonValue(ArrayProperty->Inner, Helper.GetRawPtr(i), IsValidDefaultValueIdx ? DefaultValueHelper->GetRawPtr(i) : nullptr, bElementSameValue, CheckFlags & (~CPF_ParmFlags), SkipFlags, Policy);
 					bSameValue &= bElementSameValue;
 					if (Elem.IsValid())
 					{
@@ -165,21 +302,21 @@ namespace CustomJsonConverter
 				{
 					bSameValue = true;
 				}
-				for (int32 i = 0, n = Helper.Num(); n; ++i)
+				// 先按元素排序再导出，使相同内容的集合导出的结果与对象的序号一致
+				const TArray<TPair<FString, int32>> SortedElements = SortElements(SetProperty->ElementProp, Helper.Num(),
+					[&Helper](int32 Idx) { return Helper.IsValidIndex(Idx); }, [&Helper](int32 Idx) { return Helper.GetElementPtr(Idx); });
+				Out.Reserve(SortedElements.Num());
+				for (const TPair<FString, int32>& Element : SortedElements)
 				{
-					if (Helper.IsValidIndex(i))
+					const int32 i = Element.Value;
+					const bool IsValidDefaultValueIdx = DefaultValue ? DefaultValueHelper->IsValidIndex(i) : false;
+					bool bElementSameValue;
+					TSharedPtr<FJsonValue> Elem = UPropertyToJsonValue(SetProperty->ElementProp, Helper.GetElementPtr(i), IsValidDefaultValueIdx ? DefaultValueHelper->GetElementPtr(i) : nullptr, bElementSameValue, CheckFlags & (~CPF_ParmFlags), SkipFlags, Policy);
+					bSameValue &= bElementSameValue;
+					if (Elem.IsValid())
 					{
-						const bool IsValidDefaultValueIdx = DefaultValue ? DefaultValueHelper->IsValidIndex(i) : false;
-						bool bElementSameValue;
-						TSharedPtr<FJsonValue> Elem = UPropertyToJsonValue(SetProperty->ElementProp, Helper.GetElementPtr(i), IsValidDefaultValueIdx ? DefaultValueHelper->GetElementPtr(i) : nullptr, bElementSameValue, CheckFlags & (~CPF_ParmFlags), SkipFlags, ExportCb);
-						bSameValue &= bElementSameValue;
-						if (Elem.IsValid())
-						{
-							// add to the array
-							Out.Push(Elem);
-						}
-
-						--n;
+						// add to the array
+						Out.Push(Elem);
 					}
 				}
 				return MakeShared<FJsonValueArray>(Out);
@@ -200,33 +337,33 @@ namespace CustomJsonConverter
 				{
 					bSameValue = true;
 				}
-				for (int32 i = 0, n = Helper.Num(); n; ++i)
+				// 先按键排序再导出，使相同内容的映射导出的结果与对象的序号一致
+				const TArray<TPair<FString, int32>> SortedPairs = SortElements(MapProperty->KeyProp, Helper.Num(),
+					[&Helper](int32 Idx) { return Helper.IsValidIndex(Idx); }, [&Helper](int32 Idx) { return Helper.GetKeyPtr(Idx); });
+				Out->Values.Reserve(SortedPairs.Num());
+				for (const TPair<FString, int32>& Pair : SortedPairs)
 				{
-					if (Helper.IsValidIndex(i))
+					const int32 i = Pair.Value;
+					const bool IsValidDefaultValueIdx = DefaultValue ? DefaultValueHelper->IsValidIndex(i) : false;
+					bool bKeySameValue;
+					TSharedPtr<FJsonValue> KeyElement = UPropertyToJsonValue(MapProperty->KeyProp, Helper.GetKeyPtr(i), IsValidDefaultValueIdx ? DefaultValueHelper->GetKeyPtr(i) : nullptr, bKeySameValue, CheckFlags & (~CPF_ParmFlags), SkipFlags, Policy);
+					bool bValueSameValue;
+					TSharedPtr<FJsonValue> ValueElement = UPropertyToJsonValue(MapProperty->ValueProp, Helper.GetValuePtr(i), IsValidDefaultValueIdx ? DefaultValueHelper->GetValuePtr(i) : nullptr, bValueSameValue, CheckFlags & (~CPF_ParmFlags), SkipFlags, Policy);
+					bSameValue &= bKeySameValue && bValueSameValue;
+					if (KeyElement.IsValid() && ValueElement.IsValid())
 					{
-						const bool IsValidDefaultValueIdx = DefaultValue ? DefaultValueHelper->IsValidIndex(i) : false;
-						bool bKeySameValue;
-						TSharedPtr<FJsonValue> KeyElement = UPropertyToJsonValue(MapProperty->KeyProp, Helper.GetKeyPtr(i), IsValidDefaultValueIdx ? DefaultValueHelper->GetKeyPtr(i) : nullptr, bKeySameValue, CheckFlags & (~CPF_ParmFlags), SkipFlags, ExportCb);
-						bool bValueSameValue;
-						TSharedPtr<FJsonValue> ValueElement = UPropertyToJsonValue(MapProperty->ValueProp, Helper.GetValuePtr(i), IsValidDefaultValueIdx ? DefaultValueHelper->GetValuePtr(i) : nullptr, bValueSameValue, CheckFlags & (~CPF_ParmFlags), SkipFlags, ExportCb);
-						bSameValue &= bKeySameValue && bValueSameValue;
-						if (KeyElement.IsValid() && ValueElement.IsValid())
+						FString KeyString;
+						if (!KeyElement->TryGetString(KeyString))
 						{
-							FString KeyString;
-							if (!KeyElement->TryGetString(KeyString))
+							KeyString = Pair.Key;
+							if (KeyString.IsEmpty())
 							{
-								MapProperty->KeyProp->ExportTextItem(KeyString, Helper.GetKeyPtr(i), nullptr, nullptr, 0);
-								if (KeyString.IsEmpty())
-								{
-									UE_LOG(GameSerializer_Log, Error, TEXT("Unable to convert key to string for property %s."), *MapProperty->GetName())
-										KeyString = FString::Printf(TEXT("Unparsed Key %d"), i);
-								}
+								UE_LOG(GameSerializer_Log, Error, TEXT("Unable to convert key to string for property %s."), *MapProperty->GetName())
+									KeyString = FString::Printf(TEXT("Unparsed Key %d"), i);
 							}
-
-							Out->SetField(KeyString, ValueElement);
 						}
 
-						--n;
+						Out->SetField(KeyString, ValueElement);
 					}
 				}
 
@@ -234,6 +371,26 @@ namespace CustomJsonConverter
 			}
 			else if (FStructProperty* StructProperty = CastField<FStructProperty>(Property))
 			{
+				if (const FGameSerializerNativeStruct* NativeStruct = GameSerializerNativeStruct::Find(StructProperty->Struct))
+				{
+					TSharedRef<FJsonObject> Out = MakeShared<FJsonObject>();
+					NativeStruct->Encode(Value, DefaultValue, *Out, bSameValue);
+					return MakeShared<FJsonValueObject>(Out);
+				}
+
+				if (BinaryStruct::CanExport(StructProperty->Struct))
+				{
+					if (DefaultValue)
+					{
+						bSameValue = StructProperty->Identical(Value, DefaultValue);
+					}
+					if (TSharedPtr<FJsonValue> BinaryValue = BinaryStruct::Export(StructProperty->Struct, Value))
+					{
+						return BinaryValue;
+					}
+					UE_LOG(GameSerializer_Log, Warning, TEXT("UStructToJsonObject - Binary serialize %s failed, fall back to text."), *StructProperty->Struct->GetName());
+				}
+
 				UScriptStruct::ICppStructOps* TheCppStructOps = StructProperty->Struct->GetCppStructOps();
 				// Intentionally exclude the JSON Object wrapper, which specifically needs to export JSON in an object representation instead of a string
 				if (StructProperty->Struct != FJsonObjectWrapper::StaticStruct() && TheCppStructOps && TheCppStructOps->HasExportTextItem())
@@ -244,7 +401,7 @@ namespace CustomJsonConverter
 				}
 
 				TSharedRef<FJsonObject> Out = MakeShared<FJsonObject>();
-				if (UStructToJsonAttributes(StructProperty->Struct, Value, DefaultValue, bSameValue, Out->Values, CheckFlags & (~CPF_ParmFlags), SkipFlags, ExportCb))
+				if (UStructToJsonAttributes(StructProperty->Struct, Value, DefaultValue, bSameValue, Out->Values, CheckFlags & (~CPF_ParmFlags), SkipFlags, Policy))
 				{
 					return MakeShared<FJsonValueObject>(Out);
 				}
@@ -268,11 +425,11 @@ namespace CustomJsonConverter
 			return TSharedPtr<FJsonValue>();
 		}
 
-		static TSharedPtr<FJsonValue> UPropertyToJsonValue(FProperty* Property, const void* Value, const void* DefaultValue, bool& bSameValue, int64 CheckFlags, int64 SkipFlags, const FCustomExportCallback& ExportCb)
+		static TSharedPtr<FJsonValue> UPropertyToJsonValue(FProperty* Property, const void* Value, const void* DefaultValue, bool& bSameValue, int64 CheckFlags, int64 SkipFlags, TPolicy& Policy)
 		{
 			if (Property->ArrayDim == 1)
 			{
-				return ConvertScalarFPropertyToJsonValue(Property, Value, DefaultValue, bSameValue, CheckFlags, SkipFlags, ExportCb);
+				return ConvertScalarFPropertyToJsonValue(Property, Value, DefaultValue, bSameValue, CheckFlags, SkipFlags, Policy);
 			}
 
 			bSameValue = true;
@@ -281,13 +438,13 @@ namespace CustomJsonConverter
 			{
 				const int32 Offset = Index * Property->ElementSize;
 				bool bElementSameValue;
-				Array.Add(ConvertScalarFPropertyToJsonValue(Property, (char*)Value + Offset, (char*)DefaultValue + Offset, bElementSameValue, CheckFlags, SkipFlags, ExportCb));
+				Array.Add(ConvertScalarFPropertyToJsonValue(Property, (char*)Value + Offset, (char*)DefaultValue + Offset, bElementSameValue, CheckFlags, SkipFlags, Policy));
 				bSameValue &= bElementSameValue;
 			}
 			return MakeShared<FJsonValueArray>(Array);
 		}
 
-		static bool UStructToJsonAttributes(const UStruct* StructDefinition, const void* Struct, const void* DefaultStruct, bool& bSameValue, TMap< FString, TSharedPtr<FJsonValue> >& OutJsonAttributes, int64 CheckFlags, int64 SkipFlags, const FCustomExportCallback& ExportCb)
+		static bool UStructToJsonAttributes(const UStruct* StructDefinition, const void* Struct, const void* DefaultStruct, bool& bSameValue, TMap< FString, TSharedPtr<FJsonValue> >& OutJsonAttributes, int64 CheckFlags, int64 SkipFlags, TPolicy& Policy)
 		{
 			if (SkipFlags == 0)
 			{
@@ -328,7 +485,7 @@ namespace CustomJsonConverter
 
 				bool bPropertySameValue;
 				// convert the property to a FJsonValue
-				TSharedPtr<FJsonValue> JsonValue = UPropertyToJsonValue(Property, Value, DefaultValue, bPropertySameValue, CheckFlags, SkipFlags, ExportCb);
+				TSharedPtr<FJsonValue> JsonValue = UPropertyToJsonValue(Property, Value, DefaultValue, bPropertySameValue, CheckFlags, SkipFlags, Policy);
 				bSameValue &= bPropertySameValue;
 				if (!JsonValue.IsValid())
 				{
@@ -348,9 +505,9 @@ namespace CustomJsonConverter
 		}
 	};
 
-	DECLARE_DELEGATE_RetVal_ThreeParams(bool, FCustomImportCallback, const TSharedPtr<FJsonValue>& /*JsonValue*/, FProperty* /*Property*/, void* /*OutValue*/);
-
-	struct JsonToStruct
+	// TPolicy::ImportCustomValue(JsonValue, Property, OutValue) 在类型判断前调用，返回true时跳过默认转换
+	template<typename TPolicy>
+	struct TJsonToStruct
 	{
 		static bool GetTextFromObject(const TSharedRef<FJsonObject>& Obj, FText& TextOut)
 		{
@@ -395,14 +552,11 @@ namespace CustomJsonConverter
 			return false;
 		}
 
-		static bool ConvertScalarJsonValueToFPropertyWithContainer(const TSharedPtr<FJsonValue>& JsonValue, FProperty* Property, void* OutValue, const UStruct* ContainerStruct, void* Container, int64 CheckFlags, int64 SkipFlags, const FCustomImportCallback& CustomImportCallback)
+		static bool ConvertScalarJsonValueToFPropertyWithContainer(const TSharedPtr<FJsonValue>& JsonValue, FProperty* Property, void* OutValue, const UStruct* ContainerStruct, void* Container, int64 CheckFlags, int64 SkipFlags, TPolicy& Policy)
 		{
-			if (CustomImportCallback.IsBound())
+			if (Policy.ImportCustomValue(JsonValue, Property, OutValue))
 			{
-				if (CustomImportCallback.Execute(JsonValue, Property, OutValue))
-				{
-					return true;
-				}
+				return true;
 			}
 
 			if (FEnumProperty* EnumProperty = CastField<FEnumProperty>(Property))
@@ -494,7 +648,7 @@ namespace CustomJsonConverter
 						const TSharedPtr<FJsonValue>& ArrayValueItem = ArrayValue[i];
 						if (ArrayValueItem.IsValid() && !ArrayValueItem->IsNull())
 						{
-							if (!JsonValueToFPropertyWithContainer(ArrayValueItem, ArrayProperty->Inner, Helper.GetRawPtr(i), ContainerStruct, Container, CheckFlags & (~CPF_ParmFlags), SkipFlags, CustomImportCallback))
+							if (!JsonValueToFPropertyWithContainer(ArrayValueItem, ArrayProperty->Inner, Helper.GetRawPtr(i), ContainerStruct, Container, CheckFlags & (~CPF_ParmFlags), SkipFlags, Policy))
 							{
 								UE_LOG(GameSerializer_Log, Error, TEXT("JsonValueToUProperty - Unable to deserialize array element [%d] for property %s"), i, *Property->GetNameCPP());
 								return false;
@@ -530,8 +684,8 @@ namespace CustomJsonConverter
 
 							TSharedPtr<FJsonValueString> TempKeyValue = MakeShared<FJsonValueString>(Entry.Key);
 
-							const bool bKeySuccess = JsonValueToFPropertyWithContainer(TempKeyValue, MapProperty->KeyProp, Helper.GetKeyPtr(NewIndex), ContainerStruct, Container, CheckFlags & (~CPF_ParmFlags), SkipFlags, CustomImportCallback);
-							const bool bValueSuccess = JsonValueToFPropertyWithContainer(Entry.Value, MapProperty->ValueProp, Helper.GetValuePtr(NewIndex), ContainerStruct, Container, CheckFlags & (~CPF_ParmFlags), SkipFlags, CustomImportCallback);
+							const bool bKeySuccess = JsonValueToFPropertyWithContainer(TempKeyValue, MapProperty->KeyProp, Helper.GetKeyPtr(NewIndex), ContainerStruct, Container, CheckFlags & (~CPF_ParmFlags), SkipFlags, Policy);
+							const bool bValueSuccess = JsonValueToFPropertyWithContainer(Entry.Value, MapProperty->ValueProp, Helper.GetValuePtr(NewIndex), ContainerStruct, Container, CheckFlags & (~CPF_ParmFlags), SkipFlags, Policy);
 
 							if (!(bKeySuccess && bValueSuccess))
 							{
@@ -565,7 +719,7 @@ namespace CustomJsonConverter
 						if (ArrayValueItem.IsValid() && !ArrayValueItem->IsNull())
 						{
 							int32 NewIndex = Helper.AddDefaultValue_Invalid_NeedsRehash();
-							if (!JsonValueToFPropertyWithContainer(ArrayValueItem, SetProperty->ElementProp, Helper.GetElementPtr(NewIndex), ContainerStruct, Container, CheckFlags & (~CPF_ParmFlags), SkipFlags, CustomImportCallback))
+							if (!JsonValueToFPropertyWithContainer(ArrayValueItem, SetProperty->ElementProp, Helper.GetElementPtr(NewIndex), ContainerStruct, Container, CheckFlags & (~CPF_ParmFlags), SkipFlags, Policy))
 							{
 								UE_LOG(GameSerializer_Log, Error, TEXT("JsonValueToUProperty - Unable to deserialize set element [%d] for property %s"), i, *Property->GetNameCPP());
 								return false;
@@ -613,11 +767,29 @@ namespace CustomJsonConverter
 				static const FName NAME_DateTime(TEXT("DateTime"));
 				static const FName NAME_Color(TEXT("Color"));
 				static const FName NAME_LinearColor(TEXT("LinearColor"));
-				if (JsonValue->Type == EJson::Object)
+				bool bBinarySucceed;
+				const FGameSerializerNativeStruct* NativeStruct = GameSerializerNativeStruct::Find(StructProperty->Struct);
+				if (JsonValue->Type == EJson::Object && BinaryStruct::TryImport(StructProperty->Struct, *JsonValue->AsObject(), OutValue, bBinarySucceed))
+				{
+					if (bBinarySucceed == false)
+					{
+						UE_LOG(GameSerializer_Log, Error, TEXT("JsonValueToUProperty - Binary deserialize failed for property %s"), *Property->GetNameCPP());
+						return false;
+					}
+				}
+				else if (NativeStruct && JsonValue->Type == EJson::Object)
+				{
+					if (!NativeStruct->Decode(*JsonValue->AsObject(), OutValue))
+					{
+						UE_LOG(GameSerializer_Log, Error, TEXT("JsonValueToUProperty - Native struct decode failed for property %s"), *Property->GetNameCPP());
+						return false;
+					}
+				}
+				else if (JsonValue->Type == EJson::Object)
 				{
 					TSharedPtr<FJsonObject> Obj = JsonValue->AsObject();
 					check(Obj.IsValid()); // should not fail if Type == EJson::Object
-					if (!JsonAttributesToUStructWithContainer(Obj->Values, StructProperty->Struct, OutValue, ContainerStruct, Container, CheckFlags & (~CPF_ParmFlags), SkipFlags, CustomImportCallback))
+					if (!JsonAttributesToUStructWithContainer(Obj->Values, StructProperty->Struct, OutValue, ContainerStruct, Container, CheckFlags & (~CPF_ParmFlags), SkipFlags, Policy))
 					{
 						UE_LOG(GameSerializer_Log, Error, TEXT("JsonValueToUProperty - FJsonObjectConverter::JsonObjectToUStruct failed for property %s"), *Property->GetNameCPP());
 						return false;
@@ -715,7 +887,7 @@ namespace CustomJsonConverter
 
 					TSharedPtr<FJsonObject> Obj = JsonValue->AsObject();
 					check(Obj.IsValid()); // should not fail if Type == EJson::Object
-					if (!JsonAttributesToUStructWithContainer(Obj->Values, ObjectProperty->PropertyClass, createdObj, ObjectProperty->PropertyClass, createdObj, CheckFlags & (~CPF_ParmFlags), SkipFlags, CustomImportCallback))
+					if (!JsonAttributesToUStructWithContainer(Obj->Values, ObjectProperty->PropertyClass, createdObj, ObjectProperty->PropertyClass, createdObj, CheckFlags & (~CPF_ParmFlags), SkipFlags, Policy))
 					{
 						UE_LOG(GameSerializer_Log, Error, TEXT("JsonValueToUProperty - FJsonObjectConverter::JsonObjectToUStruct failed for property %s"), *Property->GetNameCPP());
 						return false;
@@ -744,7 +916,7 @@ namespace CustomJsonConverter
 			return true;
 		}
 
-		static bool JsonValueToFPropertyWithContainer(const TSharedPtr<FJsonValue>& JsonValue, FProperty* Property, void* OutValue, const UStruct* ContainerStruct, void* Container, int64 CheckFlags, int64 SkipFlags, const FCustomImportCallback& CustomImportCallback)
+		static bool JsonValueToFPropertyWithContainer(const TSharedPtr<FJsonValue>& JsonValue, FProperty* Property, void* OutValue, const UStruct* ContainerStruct, void* Container, int64 CheckFlags, int64 SkipFlags, TPolicy& Policy)
 		{
 			if (!JsonValue.IsValid())
 			{
@@ -768,14 +940,14 @@ namespace CustomJsonConverter
 					UE_LOG(GameSerializer_Log, Warning, TEXT("Ignoring excess properties when deserializing %s"), *Property->GetName());
 				}
 
-				return ConvertScalarJsonValueToFPropertyWithContainer(JsonValue, Property, OutValue, ContainerStruct, Container, CheckFlags, SkipFlags, CustomImportCallback);
+				return ConvertScalarJsonValueToFPropertyWithContainer(JsonValue, Property, OutValue, ContainerStruct, Container, CheckFlags, SkipFlags, Policy);
 			}
 
 			// In practice, the ArrayDim == 1 check ought to be redundant, since nested arrays of FPropertys are not supported
 			if (bArrayOrSetProperty && Property->ArrayDim == 1)
 			{
 				// Read into TArray
-				return ConvertScalarJsonValueToFPropertyWithContainer(JsonValue, Property, OutValue, ContainerStruct, Container, CheckFlags, SkipFlags, CustomImportCallback);
+				return ConvertScalarJsonValueToFPropertyWithContainer(JsonValue, Property, OutValue, ContainerStruct, Container, CheckFlags, SkipFlags, Policy);
 			}
 
 			// We're deserializing a JSON array
@@ -789,7 +961,7 @@ namespace CustomJsonConverter
 			int ItemsToRead = FMath::Clamp(ArrayValue.Num(), 0, Property->ArrayDim);
 			for (int Index = 0; Index != ItemsToRead; ++Index)
 			{
-				if (!ConvertScalarJsonValueToFPropertyWithContainer(ArrayValue[Index], Property, (char*)OutValue + Index * Property->ElementSize, ContainerStruct, Container, CheckFlags, SkipFlags, CustomImportCallback))
+				if (!ConvertScalarJsonValueToFPropertyWithContainer(ArrayValue[Index], Property, (char*)OutValue + Index * Property->ElementSize, ContainerStruct, Container, CheckFlags, SkipFlags, Policy))
 				{
 					return false;
 				}
@@ -797,7 +969,7 @@ namespace CustomJsonConverter
 			return true;
 		}
 
-		static bool JsonAttributesToUStructWithContainer(const TMap< FString, TSharedPtr<FJsonValue> >& JsonAttributes, const UStruct* StructDefinition, void* OutStruct, const UStruct* ContainerStruct, void* Container, int64 CheckFlags, int64 SkipFlags, const FCustomImportCallback& CustomImportCallback)
+		static bool JsonAttributesToUStructWithContainer(const TMap< FString, TSharedPtr<FJsonValue> >& JsonAttributes, const UStruct* StructDefinition, void* OutStruct, const UStruct* ContainerStruct, void* Container, int64 CheckFlags, int64 SkipFlags, TPolicy& Policy)
 		{
 			if (StructDefinition == FJsonObjectWrapper::StaticStruct())
 			{
@@ -840,7 +1012,7 @@ namespace CustomJsonConverter
 				if (JsonValue->IsValid() && !(*JsonValue)->IsNull())
 				{
 					void* Value = Property->ContainerPtrToValuePtr<uint8>(OutStruct);
-					if (!JsonValueToFPropertyWithContainer(*JsonValue, Property, Value, ContainerStruct, Container, CheckFlags, SkipFlags, CustomImportCallback))
+					if (!JsonValueToFPropertyWithContainer(*JsonValue, Property, Value, ContainerStruct, Container, CheckFlags, SkipFlags, Policy))
 					{
 						UE_LOG(GameSerializer_Log, Error, TEXT("JsonObjectToUStruct - Unable to parse %s.%s from JSON"), *StructDefinition->GetName(), *Property->GetName());
 						return false;
@@ -859,14 +1031,22 @@ namespace CustomJsonConverter
 	};
 }
 
-FIntVector GameSerializerContext::WorldOffset = FIntVector::ZeroValue;
-
 namespace GameSerializerCore
 {
 	constexpr FObjectIdx NullIdx = 0;
 
+	// 存档格式版本
+	// 0: __ExternalObjects、__DynamicObjects、__SubObjects为以索引字符串为Key的Json对象
+	// 1: 对象表改为按索引顺序排列的数组，并记录动态对象总数
+	constexpr int32 KeyedLayoutVersion = 0;
+	constexpr int32 DenseLayoutVersion = 1;
+	constexpr int32 LatestVersion = DenseLayoutVersion;
+
 	namespace FieldName
 	{
+		constexpr TCHAR VersionFieldName[] = TEXT("__Version");
+		constexpr TCHAR ObjectCountFieldName[] = TEXT("__ObjectCount");
+		constexpr TCHAR ObjectIdxFieldName[] = TEXT("__Idx");
 		constexpr TCHAR ExternalObjectsFieldName[] = TEXT("__ExternalObjects");
 		constexpr TCHAR DynamicObjectsFieldName[] = TEXT("__DynamicObjects");
 		constexpr TCHAR SubObjectsFieldName[] = TEXT("__SubObjects");
@@ -876,15 +1056,345 @@ namespace GameSerializerCore
 		constexpr TCHAR ExtendDataTypeFieldName[] = TEXT("__Type");
 		constexpr TCHAR ActorTransformFieldName[] = TEXT("__ActorTransform");
 		constexpr TCHAR ActorOwnerFieldName[] = TEXT("__ActorOwner");
+		constexpr TCHAR ActorIdentityFieldName[] = TEXT("__Guid");
+		constexpr TCHAR DynamicObjectIndexFieldName[] = TEXT("__DynamicObjectIndex");
+	}
+
+	// __DynamicObjectIndex中每项为数组 [Idx, Class, Name, Offset, Length]，偏移相对于动态对象数据段的起始位置
+	namespace EDynamicObjectIndexEntry
+	{
+		enum Type
+		{
+			ObjectIdx,
+			ClassIdx,
+			Name,
+			Offset,
+			Length,
+			Num
+		};
 	}
+
+	// 索引格式的存档数据以"GSIX"开头，旧数据为Json文本以'{'开头
+	constexpr uint32 IndexedPayloadMagic = 0x58495347;
 	
 	using namespace CustomJsonConverter;
 	using namespace FieldName;
 
+	// 标识按四个32位整数储存，读取时不需要解析字符串
+	static TSharedRef<FJsonValue> IdentityToJson(const FGuid& Identity)
+	{
+		const TArray<TSharedPtr<FJsonValue>> Components{ MakeShared<FJsonValueNumber>(Identity.A), MakeShared<FJsonValueNumber>(Identity.B), MakeShared<FJsonValueNumber>(Identity.C), MakeShared<FJsonValueNumber>(Identity.D) };
+		return MakeShared<FJsonValueArray>(Components);
+	}
+
+	static bool TryGetIdentity(const FJsonObject& JsonObject, FGuid& OutIdentity)
+	{
+		const TArray<TSharedPtr<FJsonValue>>* Components;
+		if (JsonObject.TryGetArrayField(ActorIdentityFieldName, Components) && Components->Num() == 4)
+		{
+			OutIdentity = FGuid(uint32((*Components)[0]->AsNumber()), uint32((*Components)[1]->AsNumber()), uint32((*Components)[2]->AsNumber()), uint32((*Components)[3]->AsNumber()));
+			return OutIdentity.IsValid();
+		}
+		return false;
+	}
+
+	// 对象引用转为对象表中的索引
+	struct FObjectIdxExportPolicy
+	{
+		FStructToJson& Serializer;
+
+		FORCEINLINE TSharedPtr<FJsonValue> ExportCustomValue(FProperty* Property, const void* Value, const void* DefaultValue, bool& bSameValue)
+		{
+			return Serializer.ConvertObjectToJson(Property, Value, DefaultValue, bSameValue);
+		}
+	};
+
+	// 对象表中的索引转为对象引用
+	struct FObjectIdxImportPolicy
+	{
+		const FJsonToStruct& Deserializer;
+
+		FORCEINLINE bool ImportCustomValue(const TSharedPtr<FJsonValue>& JsonValue, FProperty* Property, void* OutValue)
+		{
+			return Deserializer.JsonObjectIdxToObject(JsonValue, Property, OutValue);
+		}
+	};
+
+	// 读取对象属性时同时收集需要调用的RepNotify
+	struct FRepNotifyImportPolicy : FObjectIdxImportPolicy
+	{
+		const FGameSerializerRepNotifyTable& RepNotifyTable;
+		TArray<FGameSerializerNetNotifyData>& AllNetNotifyData;
+
+		FORCEINLINE bool ImportCustomValue(const TSharedPtr<FJsonValue>& JsonValue, FProperty* Property, void* OutValue)
+		{
+			if (Property->HasAnyPropertyFlags(CPF_RepNotify))
+			{
+				const FGameSerializerRepNotifyTable::FEntry* Entry = RepNotifyTable.Find(Property);
+				if (ensure(Entry) && Entry->bIgnored == false)
+				{
+					AllNetNotifyData.Add(FGameSerializerNetNotifyData{ Property, Entry->RepNotifyFunc, Entry->Params });
+				}
+			}
+			return FObjectIdxImportPolicy::ImportCustomValue(JsonValue, Property, OutValue);
+		}
+	};
+
+	FObjectIdx* FObjectIndexTable::Find(const UObject* Object)
+	{
+		const int32 ObjectIndex = GUObjectArray.ObjectToIndex(Object);
+		const int32 PageIdx = ObjectIndex >> PageBits;
+		if (Pages.IsValidIndex(PageIdx) == false || Pages[PageIdx] == nullptr)
+		{
+			return nullptr;
+		}
+		// 没有分配过序列号的对象不可能被记录过
+		const int32 SerialNumber = GUObjectArray.IndexToObject(ObjectIndex)->GetSerialNumber();
+		FPage& Page = *Pages[PageIdx];
+		const int32 SlotIdx = ObjectIndex & (PageSize - 1);
+		if (SerialNumber == 0 || (Page.VisitedMask[SlotIdx >> 6] & (uint64(1) << (SlotIdx & 63))) == 0 || Page.Slots[SlotIdx].SerialNumber != SerialNumber)
+		{
+			return nullptr;
+		}
+		return &Page.Slots[SlotIdx].Value;
+	}
+
+	FObjectIdx& FObjectIndexTable::FindOrAdd(const UObject* Object)
+	{
+		const int32 ObjectIndex = GUObjectArray.ObjectToIndex(Object);
+		const int32 PageIdx = ObjectIndex >> PageBits;
+		if (Pages.Num() <= PageIdx)
+		{
+			Pages.SetNum(PageIdx + 1);
+		}
+		TUniquePtr<FPage>& PagePtr = Pages[PageIdx];
+		if (PagePtr == nullptr)
+		{
+			PagePtr = MakeUnique<FPage>();
+		}
+		int32 SerialNumber = GUObjectArray.IndexToObject(ObjectIndex)->GetSerialNumber();
+		if (SerialNumber == 0)
+		{
+			SerialNumber = GUObjectArray.AllocateSerialNumber(ObjectIndex);
+		}
+		FPage& Page = *PagePtr;
+		const int32 SlotIdx = ObjectIndex & (PageSize - 1);
+		uint64& VisitedMask = Page.VisitedMask[SlotIdx >> 6];
+		const uint64 VisitedBit = uint64(1) << (SlotIdx & 63);
+		FSlot& Slot = Page.Slots[SlotIdx];
+		if ((VisitedMask & VisitedBit) == 0 || Slot.SerialNumber != SerialNumber)
+		{
+			VisitedMask |= VisitedBit;
+			Slot.SerialNumber = SerialNumber;
+			Slot.Value = NullIdx;
+		}
+		return Slot.Value;
+	}
+
+	FObjectBaselines::FObjectBaselines(EPropertyFlags CheckFlags)
+		: CheckFlags(CheckFlags)
+	{}
+
+	FObjectBaselines::~FObjectBaselines()
+	{
+		for (TPair<TWeakObjectPtr<const UObject>, FBaseline>& Pair : Baselines)
+		{
+			Release(Pair.Value);
+		}
+	}
+
+	void FObjectBaselines::Release(FBaseline& Baseline)
+	{
+		if (Baseline.Data)
+		{
+			Baseline.Class->DestroyStruct(Baseline.Data);
+			FMemory::Free(Baseline.Data);
+			Baseline.Data = nullptr;
+		}
+	}
+
+	void FObjectBaselines::Capture(UObject* Object, const FTransform* ActorTransform)
+	{
+		UClass* Class = Object->GetClass();
+		
+		FBaseline Baseline;
+		Baseline.Class = Class;
+		if (const AActor* Actor = Cast<AActor>(Object))
+		{
+			Baseline.ActorTransform = ActorTransform ? *ActorTransform : Actor->GetActorTransform();
+		}
+		for (TFieldIterator<FProperty> It(Class); It; ++It)
+		{
+			const FProperty* Property = *It;
+			if (CheckFlags != 0 && !Property->HasAnyPropertyFlags(CheckFlags))
+			{
+				continue;
+			}
+			if (Baseline.Data == nullptr)
+			{
+				Baseline.Data = static_cast<uint8*>(FMemory::Malloc(Class->GetStructureSize(), Class->GetMinAlignment()));
+				Class->InitializeStruct(Baseline.Data);
+			}
+			Property->CopyCompleteValue_InContainer(Baseline.Data, Object);
+		}
+
+		if (Baseline.Data == nullptr && Baseline.ActorTransform.IsSet() == false)
+		{
+			return;
+		}
+		if (FBaseline* ExistBaseline = Baselines.Find(Object))
+		{
+			Release(*ExistBaseline);
+			*ExistBaseline = Baseline;
+		}
+		else
+		{
+			Baselines.Add(Object, Baseline);
+		}
+	}
+
+	void FObjectBaselines::CaptureActor(AActor* Actor, const FTransform* PendingLevelTransform)
+	{
+		const USceneComponent* RootComponent = Actor->GetRootComponent();
+		if (PendingLevelTransform && RootComponent)
+		{
+			// 关卡变换只作用于没有挂接的根组件
+			FTransform ActorTransform = FTransform::Identity;
+			const USceneComponent* TopComponent = RootComponent;
+			for (const USceneComponent* Component = RootComponent; Component; Component = Component->GetAttachParent())
+			{
+				ActorTransform = ActorTransform * Component->GetRelativeTransform();
+				TopComponent = Component;
+			}
+			if (TopComponent->GetOwner() && TopComponent->GetOwner()->GetLevel() == Actor->GetLevel())
+			{
+				ActorTransform = ActorTransform * *PendingLevelTransform;
+			}
+			Capture(Actor, &ActorTransform);
+		}
+		else
+		{
+			Capture(Actor);
+		}
+		for (UActorComponent* Component : Actor->GetComponents())
+		{
+			if (Component)
+			{
+				Capture(Component);
+			}
+		}
+	}
+
+	const void* FObjectBaselines::Find(const UObject* Object) const
+	{
+		const FBaseline* Baseline = Baselines.Find(Object);
+		return Baseline && Baseline->Class == Object->GetClass() ? Baseline->Data : nullptr;
+	}
+
+	const FTransform* FObjectBaselines::FindActorTransform(const AActor* Actor) const
+	{
+		const FBaseline* Baseline = Baselines.Find(Actor);
+		return Baseline && Baseline->ActorTransform.IsSet() ? &Baseline->ActorTransform.GetValue() : nullptr;
+	}
+
+	void FObjectBaselines::AddReferencedObjects(FReferenceCollector& Collector)
+	{
+		// 复制的属性中的对象引用需要告知GC，避免被回收后地址被复用时比较出错
+		for (TPair<TWeakObjectPtr<const UObject>, FBaseline>& Pair : Baselines)
+		{
+			FBaseline& Baseline = Pair.Value;
+			Collector.AddReferencedObject(Baseline.Class);
+			if (Baseline.Data && Baseline.Class)
+			{
+				Collector.AddPropertyReferences(Baseline.Class, Baseline.Data);
+			}
+		}
+	}
+
+	FString FObjectBaselines::GetReferencerName() const
+	{
+		return TEXT("GameSerializerCore::FObjectBaselines");
+	}
+
+	// 扩展数据的默认值只用于比较，每个类型只构造一次且不会被修改
+	static const void* GetDefaultExtendData(const UScriptStruct* Struct)
+	{
+		check(IsInGameThread());
+
+		struct FDefaultExtendData
+		{
+			TWeakObjectPtr<const UScriptStruct> Struct;
+			uint8* Data = nullptr;
+		};
+		static TMap<const UScriptStruct*, FDefaultExtendData> DefaultExtendDataMap;
+
+		FDefaultExtendData& DefaultExtendData = DefaultExtendDataMap.FindOrAdd(Struct);
+		if (DefaultExtendData.Struct.Get() != Struct)
+		{
+			// 原类型已被回收，无法再析构，只释放内存
+			FMemory::Free(DefaultExtendData.Data);
+			DefaultExtendData.Struct = Struct;
+			DefaultExtendData.Data = static_cast<uint8*>(FMemory::Malloc(Struct->GetStructureSize(), Struct->GetMinAlignment()));
+			Struct->InitializeStruct(DefaultExtendData.Data);
+		}
+		return DefaultExtendData.Data;
+	}
+
+	FExtendDataArena::~FExtendDataArena()
+	{
+		for (uint8* Block : Blocks)
+		{
+			FMemory::Free(Block);
+		}
+	}
+
+	TSharedRef<FGameSerializerExtendData> FExtendDataArena::Allocate(const UScriptStruct* Struct)
+	{
+		const int32 Size = Struct->GetStructureSize();
+		const int32 Alignment = FMath::Max(Struct->GetMinAlignment(), 1);
+
+		uint8* Data;
+		if (Size + Alignment > BlockSize)
+		{
+			// 过大的扩展数据单独分配，同样在分配器销毁时回收
+			Data = static_cast<uint8*>(FMemory::Malloc(Size, Alignment));
+			Blocks.Insert(Data, 0);
+			AllocatedSize += Size;
+		}
+		else
+		{
+			// 按实际地址对齐，块的起始地址不一定满足该类型的对齐要求
+			int32 AlignedOffset = BlockOffset < BlockSize ? int32(Align(Blocks.Last() + BlockOffset, Alignment) - Blocks.Last()) : BlockSize;
+			if (AlignedOffset + Size > BlockSize)
+			{
+				Blocks.Add(static_cast<uint8*>(FMemory::Malloc(BlockSize, Alignment)));
+				AllocatedSize += BlockSize;
+				AlignedOffset = 0;
+			}
+			Data = Blocks.Last() + AlignedOffset;
+			BlockOffset = AlignedOffset + Size;
+		}
+
+		FGameSerializerExtendData* ExtendData = reinterpret_cast<FGameSerializerExtendData*>(Data);
+		Struct->InitializeStruct(ExtendData);
+		// 只析构不释放，内存随分配器回收
+		return MakeShareable(ExtendData, [Arena = AsShared(), Struct](FGameSerializerExtendData* ExtendDataToDestroy)
+		{
+			Struct->DestroyStruct(ExtendDataToDestroy);
+		});
+	}
+
 	FStructToJson::FStructToJson()
 	{
-		RootJsonObject->SetObjectField(ExternalObjectsFieldName, ExternalJsonObject);
-		RootJsonObject->SetObjectField(DynamicObjectsFieldName, DynamicJsonObject);
+		RootJsonObject->SetNumberField(VersionFieldName, LatestVersion);
+	}
+
+	const TSharedRef<FJsonObject>& FStructToJson::GetResultJson()
+	{
+		RootJsonObject->SetNumberField(ObjectCountFieldName, ObjectUniqueIdx);
+		RootJsonObject->SetArrayField(ExternalObjectsFieldName, ExternalObjectsJsonArray);
+		RootJsonObject->SetArrayField(DynamicObjectsFieldName, DynamicObjectsJsonArray);
+		return RootJsonObject;
 	}
 
 	DECLARE_CYCLE_STAT(TEXT("StructToJson_AddObjects"), STAT_StructToJson_AddObjects, STATGROUP_GameSerializer);
@@ -909,7 +1419,7 @@ namespace GameSerializerCore
 
 	FObjectIdx FStructToJson::GetExternalObjectIndex(const UObject* ExternalObject)
 	{
-		FObjectIdx& ExternalObjectIdx = ExternalObjectIdxMap.FindOrAdd(ExternalObject);
+		FObjectIdx& ExternalObjectIdx = ExternalObjectIdxTable.FindOrAdd(ExternalObject);
 		if (ExternalObjectIdx == NullIdx)
 		{
 			ExternalObjectUniqueIdx -= 1;
@@ -929,33 +1439,64 @@ namespace GameSerializerCore
 			}
 #endif
 			SoftObjectPath.ExportTextItem(SoftObjectPathString, FSoftObjectPath(), nullptr, PPF_None, nullptr);
-			ExternalJsonObject->SetStringField(FString::FromInt(ExternalObjectUniqueIdx), SoftObjectPathString);
+			check(ExternalObjectsJsonArray.Num() == -ExternalObjectUniqueIdx - 1);
+			ExternalObjectsJsonArray.Add(MakeShared<FJsonValueString>(SoftObjectPathString));
 		}
 		return ExternalObjectIdx;
 	}
 
+	UObject* FStructToJson::GetSerializedOuter(const UObject* Object)
+	{
+		if (UObject** SerializedOuter = SerializedOuterMap.Find(Object))
+		{
+			return *SerializedOuter;
+		}
+		const AActor* Actor = Cast<AActor>(Object);
+		UObject* SerializedOuter = Actor ? IActorGameSerializerInterface::GetGameSerializedOwner(Actor) : IGameSerializerInterface::GetGameSerializedOuter(Object);
+		SerializedOuterMap.Add(Object, SerializedOuter);
+		return SerializedOuter;
+	}
+
 	FObjectIdx FStructToJson::ObjectToJsonObject(const TSharedRef<FJsonObject>& JsonObject, UObject* Object)
 	{
-		OuterChain.Add(FOuterData(Object, JsonObject));
+		OuterChainIndexMap.Add(Object, OuterChain.Add(FOuterData(Object, JsonObject)));
 		ON_SCOPE_EXIT
 		{
+			FOuterData& OuterData = OuterChain.Last();
+			if (OuterData.SubObjectsJsonArray.Num() > 0)
+			{
+				JsonObject->SetArrayField(SubObjectsFieldName, OuterData.SubObjectsJsonArray);
+			}
+			OuterChainIndexMap.Remove(OuterData.Outer);
 			OuterChain.Pop();
 		};
 		UClass* Class = Object->GetClass();
 
-		check(ObjectIdxMap.Contains(Object) == false);
+		check(ObjectIdxTable.Find(Object) == nullptr);
 		ObjectUniqueIdx += 1;
 		const FObjectIdx ObjectIdx = ObjectUniqueIdx;
-		ObjectIdxMap.Add(Object, ObjectIdx);
+		ObjectIdxTable.Add(Object, ObjectIdx);
 
+		JsonObject->SetNumberField(ObjectIdxFieldName, ObjectIdx);
 		JsonObject->SetStringField(ObjectNameFieldName, Object->GetName());
 		JsonObject->SetNumberField(ObjectClassFieldName, GetExternalObjectIndex(Class));
 
 		if (AActor* Actor = Cast<AActor>(Object))
 		{
-			AddStruct(JsonObject, ActorTransformFieldName, Actor->GetActorTransform());
+			// 与基准相同时不记录，读档时保持关卡中的位置
+			// 没有基准的Actor（运行时生成的Actor等）总是记录，读档时与之前一样总会设置位置
+			const FTransform* BaselineTransform = Baselines ? Baselines->FindActorTransform(Actor) : nullptr;
+			const FTransform ActorTransform = Actor->GetActorTransform();
+			AddStruct(JsonObject, ActorTransformFieldName, TBaseStructure<FTransform>::Get(), &ActorTransform, BaselineTransform);
+
+			const UGameSerializerIdentityComponent* IdentityComponent = UGameSerializerIdentityComponent::Find(Actor);
+			if (IdentityComponent && IdentityComponent->GetIdentity().IsValid())
+			{
+				JsonObject->SetField(ActorIdentityFieldName, IdentityToJson(IdentityComponent->GetIdentity()));
+			}
 		}
 		
+		FObjectIdxExportPolicy ExportPolicy{ *this };
 		const FGameSerializerExtendDataContainer ExtendDataContainer = IGameSerializerInterface::WhenGamePreSave(Object);
 		if (ExtendDataContainer.Struct && ensure(ExtendDataContainer.ExtendData.IsValid()))
 		{
@@ -963,14 +1504,10 @@ namespace GameSerializerCore
 			const FObjectIdx StructIdx = GetExternalObjectIndex(ExtendDataContainer.Struct);
 			ExtendDataContainerJsonObject->SetNumberField(ExtendDataTypeFieldName, StructIdx);
 
-			const UScriptStruct* Struct = ExtendDataContainer.Struct;
-			FGameSerializerExtendData* DefaultExtendData = static_cast<FGameSerializerExtendData*>(FMemory::Malloc(Struct->GetStructureSize(), Struct->GetMinAlignment()));
-			ExtendDataContainer.Struct->InitializeStruct(DefaultExtendData);
+			const void* DefaultExtendData = GetDefaultExtendData(ExtendDataContainer.Struct);
 			bool bSubObjectSameValue;
-			const bool IsSaveSucceed = StructToJson::UStructToJsonAttributes(ExtendDataContainer.Struct, ExtendDataContainer.ExtendData.Get(), DefaultExtendData, bSubObjectSameValue, ExtendDataContainerJsonObject->Values, CheckFlags, SkipFlags, FCustomExportCallback::CreateRaw(this, &FStructToJson::ConvertObjectToJson));
+			const bool IsSaveSucceed = TStructToJson<FObjectIdxExportPolicy>::UStructToJsonAttributes(ExtendDataContainer.Struct, ExtendDataContainer.ExtendData.Get(), DefaultExtendData, bSubObjectSameValue, ExtendDataContainerJsonObject->Values, CheckFlags, SkipFlags, ExportPolicy);
 			ensure(IsSaveSucceed);
-			ExtendDataContainer.Struct->DestroyStruct(DefaultExtendData);
-			FMemory::Free(DefaultExtendData);
 
 			if (bSubObjectSameValue == false)
 			{
@@ -978,8 +1515,13 @@ namespace GameSerializerCore
 			}
 		}
 
+		const void* DefaultObject = Baselines ? Baselines->Find(Object) : nullptr;
+		if (DefaultObject == nullptr)
+		{
+			DefaultObject = Class->GetDefaultObject();
+		}
 		bool bSameValue;
-		const bool IsSaveSucceed = StructToJson::UStructToJsonAttributes(Class, Object, Class->GetDefaultObject(), bSameValue, JsonObject->Values, CheckFlags, SkipFlags, FCustomExportCallback::CreateRaw(this, &FStructToJson::ConvertObjectToJson));
+		const bool IsSaveSucceed = TStructToJson<FObjectIdxExportPolicy>::UStructToJsonAttributes(Class, Object, DefaultObject, bSameValue, JsonObject->Values, CheckFlags, SkipFlags, ExportPolicy);
 		ensure(IsSaveSucceed);
 		return ObjectIdx;
 	}
@@ -990,7 +1532,7 @@ namespace GameSerializerCore
 		{
 			return NullIdx;
 		}
-		else if (FObjectIdx* ExistObjectIdx = ObjectIdxMap.Find(Object))
+		else if (FObjectIdx* ExistObjectIdx = ObjectIdxTable.Find(Object))
 		{
 			return *ExistObjectIdx;
 		}
@@ -1001,9 +1543,10 @@ namespace GameSerializerCore
 		}
 		else
 		{
+			// 先加入数组再分配索引，保证数组内索引升序
 			const TSharedRef<FJsonObject> JsonObject = MakeShared<FJsonObject>();
+			DynamicObjectsJsonArray.Add(MakeShared<FJsonValueObject>(JsonObject));
 			const FObjectIdx NewObjectIdx = ObjectToJsonObject(JsonObject, Object);
-			DynamicJsonObject->SetObjectField(FString::FromInt(NewObjectIdx), JsonObject);
 
 			return NewObjectIdx;
 		}
@@ -1023,7 +1566,7 @@ namespace GameSerializerCore
 			
 			if (SubObject != nullptr)
 			{
-				if (FObjectIdx* ObjectIdx = ObjectIdxMap.Find(SubObject))
+				if (FObjectIdx* ObjectIdx = ObjectIdxTable.Find(SubObject))
 				{
 					return MakeShared<FJsonValueNumber>(*ObjectIdx);
 				}
@@ -1036,52 +1579,31 @@ namespace GameSerializerCore
 					return MakeShared<FJsonValueNumber>(ExternalObjectIdx);
 				}
 
-				// Actor用Owner进行归属的判断
-				if (const AActor* SubActor = Cast<AActor>(SubObject))
+				// Actor用Owner进行归属的判断，其余对象用Outer，归属的对象正在储存时一并储存
+				UObject* SerializedOuter = GetSerializedOuter(SubObject);
+				if (const int32* OuterChainIdx = SerializedOuter ? OuterChainIndexMap.Find(SerializedOuter) : nullptr)
 				{
-					for (FObjectIdx Idx = OuterChain.Num() - 1; Idx >= 0; --Idx)
+					if (const AActor* SubActor = Cast<AActor>(SubObject))
 					{
-						AActor* SubActorOwner = IActorGameSerializerInterface::GetGameSerializedOwner(SubActor);
-						if (SubActorOwner == OuterChain[Idx].Outer)
-						{
-							// SubActor的命名约定要存在Owner的名称，避免读档时已经存在重名的Actor（不由Owner生成的）
-							ensure(SubActor->GetName().Contains(SubActorOwner->GetName()));
-							
-							const TSharedRef<FJsonObject> SubActorJsonObject = MakeShared<FJsonObject>();
-							SubActorJsonObject->SetNumberField(ActorOwnerFieldName, ObjectIdxMap[SubActorOwner]);
-							const FObjectIdx ObjectIdx = ObjectToJsonObject(SubActorJsonObject, SubObject);
-							
-							DynamicJsonObject->SetObjectField(FString::FromInt(ObjectIdx), SubActorJsonObject);
-							return MakeShared<FJsonValueNumber>(ObjectIdx);
-						}
+						// SubActor的命名约定要存在Owner的名称，避免读档时已经存在重名的Actor（不由Owner生成的）
+						// 有持久标识的Actor通过标识找回，不受命名约定限制
+						ensure(UGameSerializerIdentityComponent::Find(SubActor) || SubActor->GetName().Contains(SerializedOuter->GetName()));
+
+						const TSharedRef<FJsonObject> SubActorJsonObject = MakeShared<FJsonObject>();
+						SubActorJsonObject->SetNumberField(ActorOwnerFieldName, *ObjectIdxTable.Find(SerializedOuter));
+						DynamicObjectsJsonArray.Add(MakeShared<FJsonValueObject>(SubActorJsonObject));
+						const FObjectIdx ObjectIdx = ObjectToJsonObject(SubActorJsonObject, SubObject);
+
+						return MakeShared<FJsonValueNumber>(ObjectIdx);
 					}
-				}
-				else
-				{
-					// 能找到Outer的储存所有数据
-					for (FObjectIdx Idx = OuterChain.Num() - 1; Idx >= 0; --Idx)
+					else
 					{
-						const FOuterData& TestOuterData = OuterChain[Idx];
-						const UObject* GameSerializedOuter = IGameSerializerInterface::GetGameSerializedOuter(SubObject);
-						if (GameSerializedOuter == TestOuterData.Outer)
-						{
-							TSharedPtr<FJsonObject> SubObjectsJsonObject;
-							if (TestOuterData.OuterJsonObject->HasField(SubObjectsFieldName))
-							{
-								SubObjectsJsonObject = TestOuterData.OuterJsonObject->GetObjectField(SubObjectsFieldName);
-							}
-							else
-							{
-								SubObjectsJsonObject = MakeShared<FJsonObject>();
-								TestOuterData.OuterJsonObject->SetObjectField(SubObjectsFieldName, SubObjectsJsonObject);
-							}
-
-							const TSharedRef<FJsonObject> SubObjectJsonObject = MakeShared<FJsonObject>();
+						// Outer退出时统一写入__SubObjects
+						const TSharedRef<FJsonObject> SubObjectJsonObject = MakeShared<FJsonObject>();
+						OuterChain[*OuterChainIdx].SubObjectsJsonArray.Add(MakeShared<FJsonValueObject>(SubObjectJsonObject));
 
-							const FObjectIdx ObjectIdx = ObjectToJsonObject(SubObjectJsonObject, SubObject);
-							SubObjectsJsonObject->SetObjectField(FString::FromInt(ObjectIdx), SubObjectJsonObject);
-							return MakeShared<FJsonValueNumber>(ObjectIdx);
-						}
+						const FObjectIdx ObjectIdx = ObjectToJsonObject(SubObjectJsonObject, SubObject);
+						return MakeShared<FJsonValueNumber>(ObjectIdx);
 					}
 				}
 
@@ -1101,7 +1623,8 @@ namespace GameSerializerCore
 	{
 		const TSharedRef<FJsonObject> StructJsonObject = MakeShared<FJsonObject>();
 		bool bSameValue;
-		const bool IsSaveSucceed = StructToJson::UStructToJsonAttributes(Struct, Value, DefaultValue, bSameValue, StructJsonObject->Values, CheckFlags, SkipFlags, FCustomExportCallback::CreateRaw(this, &FStructToJson::ConvertObjectToJson));
+		FObjectIdxExportPolicy ExportPolicy{ *this };
+		const bool IsSaveSucceed = TStructToJson<FObjectIdxExportPolicy>::UStructToJsonAttributes(Struct, Value, DefaultValue, bSameValue, StructJsonObject->Values, CheckFlags, SkipFlags, ExportPolicy);
 		ensure(IsSaveSucceed);
 		if (bSameValue == false)
 		{
@@ -1113,7 +1636,24 @@ namespace GameSerializerCore
 		: Outer(Outer)
 	    , RootJsonObject(RootJsonObject)
 	{
-
+		const TArray<TSharedPtr<FJsonValue>>* IndexJsonArray;
+		if (RootJsonObject->TryGetArrayField(DynamicObjectIndexFieldName, IndexJsonArray))
+		{
+			DynamicObjectIndex.Reserve(IndexJsonArray->Num());
+			for (const TSharedPtr<FJsonValue>& EntryJsonValue : *IndexJsonArray)
+			{
+				const TArray<TSharedPtr<FJsonValue>>& EntryJsonArray = EntryJsonValue->AsArray();
+				if (ensure(EntryJsonArray.Num() == EDynamicObjectIndexEntry::Num) == false)
+				{
+					DynamicObjectIndex.Reset();
+					break;
+				}
+				FDynamicObjectIndexEntry& Entry = DynamicObjectIndex.AddDefaulted_GetRef();
+				Entry.ObjectIdx = int32(EntryJsonArray[EDynamicObjectIndexEntry::ObjectIdx]->AsNumber());
+				Entry.ClassIdx = int32(EntryJsonArray[EDynamicObjectIndexEntry::ClassIdx]->AsNumber());
+				Entry.Name = EntryJsonArray[EDynamicObjectIndexEntry::Name]->AsString();
+			}
+		}
 	}
 
 	DECLARE_CYCLE_STAT(TEXT("JsonToStruct_LoadExternalObject"), STAT_JsonToStruct_LoadExternalObject, STATGROUP_GameSerializer);
@@ -1121,13 +1661,8 @@ namespace GameSerializerCore
 	{
 		GameSerializerStatLog(STAT_JsonToStruct_LoadExternalObject);
 
-		const TSharedPtr<FJsonObject> ExternalObjectJsonObject = RootJsonObject->GetObjectField(ExternalObjectsFieldName);
-		for (const TPair<FString, TSharedPtr<FJsonValue>>& Pair : ExternalObjectJsonObject->Values)
+		auto LoadExternalObjectByPath = [this](const FObjectIdx Idx, const FString& SoftObjectPathString)
 		{
-			const FObjectIdx Idx = -FCString::Atoi(*Pair.Key);
-			ExternalObjectsArray.SetNumUninitialized(Idx + 1);
-
-			const FString SoftObjectPathString = Pair.Value->AsString();
 			const TCHAR* Buffer = *SoftObjectPathString;
 
 			FSoftObjectPath SoftObjectPath;
@@ -1151,6 +1686,69 @@ namespace GameSerializerCore
 				UE_LOG(GameSerializer_Log, Warning, TEXT("未能加载对象 [%s]"), *SoftObjectPath.ToString());
 			}
 			ExternalObjectsArray[Idx] = ExternalObject;
+		};
+
+		const TArray<TSharedPtr<FJsonValue>>* ExternalObjectsJsonArray;
+		if (RootJsonObject->TryGetArrayField(ExternalObjectsFieldName, ExternalObjectsJsonArray))
+		{
+			ExternalObjectsArray.SetNumZeroed(ExternalObjectsJsonArray->Num() + 1);
+			for (int32 ArrayIdx = 0; ArrayIdx < ExternalObjectsJsonArray->Num(); ++ArrayIdx)
+			{
+				LoadExternalObjectByPath(ArrayIdx + 1, (*ExternalObjectsJsonArray)[ArrayIdx]->AsString());
+			}
+		}
+		else
+		{
+			// 兼容KeyedLayoutVersion，外部对象的索引同样是连续的
+			const TSharedPtr<FJsonObject> ExternalObjectJsonObject = RootJsonObject->GetObjectField(ExternalObjectsFieldName);
+			ExternalObjectsArray.SetNumZeroed(ExternalObjectJsonObject->Values.Num() + 1);
+			for (const TPair<FString, TSharedPtr<FJsonValue>>& Pair : ExternalObjectJsonObject->Values)
+			{
+				const FObjectIdx Idx = -FCString::Atoi(*Pair.Key);
+				if (ExternalObjectsArray.IsValidIndex(Idx) == false)
+				{
+					ExternalObjectsArray.SetNumZeroed(Idx + 1);
+				}
+				LoadExternalObjectByPath(Idx, Pair.Value->AsString());
+			}
+		}
+	}
+
+	DECLARE_CYCLE_STAT(TEXT("JsonToStruct_ParseDynamicObject"), STAT_JsonToStruct_ParseDynamicObject, STATGROUP_GameSerializer);
+	void FJsonToStruct::StartParseDynamicObjects()
+	{
+		const TArray<TSharedPtr<FJsonValue>>* DynamicObjectsJsonArray;
+		if (ParseDynamicObjectsTask.IsValid() || DynamicObjectIndex.Num() == 0 || RootJsonObject->TryGetArrayField(DynamicObjectsFieldName, DynamicObjectsJsonArray) == false
+			|| ensure(DynamicObjectIndex.Num() == DynamicObjectsJsonArray->Num()) == false)
+		{
+			return;
+		}
+
+		// 类型丢失的对象无法实例化，仍保持未解析
+		TArray<TSharedPtr<FJsonValue>> ParseJsonValues;
+		ParseJsonValues.Reserve(DynamicObjectsJsonArray->Num());
+		for (int32 ArrayIdx = 0; ArrayIdx < DynamicObjectsJsonArray->Num(); ++ArrayIdx)
+		{
+			if (GetObjectByIdx(DynamicObjectIndex[ArrayIdx].ClassIdx))
+			{
+				ParseJsonValues.Add((*DynamicObjectsJsonArray)[ArrayIdx]);
+			}
+		}
+		ParseDynamicObjectsTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [ParseJsonValues = MoveTemp(ParseJsonValues)]
+		{
+			GameSerializerStatLog(STAT_JsonToStruct_ParseDynamicObject);
+			for (const TSharedPtr<FJsonValue>& JsonValue : ParseJsonValues)
+			{
+				JsonValue->AsObject();
+			}
+		});
+	}
+
+	void FJsonToStruct::WaitParseDynamicObjects() const
+	{
+		if (ParseDynamicObjectsTask.IsValid())
+		{
+			ParseDynamicObjectsTask.Wait();
 		}
 	}
 
@@ -1158,12 +1756,53 @@ namespace GameSerializerCore
 	void FJsonToStruct::InstanceDynamicObject()
 	{
 		GameSerializerStatLog(STAT_JsonToStruct_InstanceDynamicObject);
+		WaitParseDynamicObjects();
+		ON_SCOPE_EXIT
+		{
+			ExistingObjectsMap.Empty();
+		};
+
+		FObjectIdx ObjectCount;
+		if (RootJsonObject->TryGetNumberField(ObjectCountFieldName, ObjectCount))
+		{
+			ObjectsArray.SetNumZeroed(ObjectCount + 1);
+			AllInstancedObjectData.Reserve(ObjectCount);
+		}
+
+		const TArray<TSharedPtr<FJsonValue>>* DynamicObjectsJsonArray;
+		if (RootJsonObject->TryGetArrayField(DynamicObjectsFieldName, DynamicObjectsJsonArray))
+		{
+			const bool bHasIndex = DynamicObjectIndex.Num() > 0 && ensure(DynamicObjectIndex.Num() == DynamicObjectsJsonArray->Num());
+			for (int32 ArrayIdx = 0; ArrayIdx < DynamicObjectsJsonArray->Num(); ++ArrayIdx)
+			{
+				const FDynamicObjectIndexEntry* IndexEntry = bHasIndex ? &DynamicObjectIndex[ArrayIdx] : nullptr;
+				// 类型丢失的对象无法实例化，不需要解析
+				if (IndexEntry && GetObjectByIdx(IndexEntry->ClassIdx) == nullptr)
+				{
+					continue;
+				}
 
-		const TSharedPtr<FJsonObject> DynamicJsonObject = RootJsonObject->GetObjectField(DynamicObjectsFieldName);
-		for (const TPair<FString, TSharedPtr<FJsonValue>>& Pair : DynamicJsonObject->Values)
+				// 索引格式下没有提前开始解析时在此处才解析对象数据
+				const TSharedPtr<FJsonObject>& DynamicObjectJsonObject = (*DynamicObjectsJsonArray)[ArrayIdx]->AsObject();
+				if (ensure(DynamicObjectJsonObject.IsValid()) == false)
+				{
+					continue;
+				}
+				if (IndexEntry && IndexEntry->bRetargeted)
+				{
+					DynamicObjectJsonObject->SetStringField(ObjectNameFieldName, IndexEntry->Name);
+				}
+				JsonObjectToInstanceObject(DynamicObjectJsonObject.ToSharedRef(), DynamicObjectJsonObject->GetIntegerField(ObjectIdxFieldName));
+			}
+		}
+		else
 		{
-			const FObjectIdx Idx = FCString::Atoi(*Pair.Key);
-			JsonObjectToInstanceObject(Pair.Value->AsObject().ToSharedRef(), Idx);
+			const TSharedPtr<FJsonObject> DynamicJsonObject = RootJsonObject->GetObjectField(DynamicObjectsFieldName);
+			for (const TPair<FString, TSharedPtr<FJsonValue>>& Pair : DynamicJsonObject->Values)
+			{
+				const FObjectIdx Idx = FCString::Atoi(*Pair.Key);
+				JsonObjectToInstanceObject(Pair.Value->AsObject().ToSharedRef(), Idx);
+			}
 		}
 	}
 
@@ -1191,34 +1830,40 @@ namespace GameSerializerCore
 					}
 				}
 
-				TArray<FName> CallRepNotifyIgnorePropertyNames;
-				if (InstancedObject->Implements<UGameSerializerInterface>())
-				{
-					CallRepNotifyIgnorePropertyNames = IGameSerializerInterface::GetCallRepNotifyIgnorePropertyNames(InstancedObject);
-				}
+				const TSharedRef<const FGameSerializerRepNotifyTable> RepNotifyTable = GameSerializerRepNotifyTable::Get(Class);
+				InstancedObjectData.RepNotifyTable = RepNotifyTable;
 				
-				TArray<FGameSerializerNetNotifyData>& AllNetNotifyData = InstancedObjectData.AllNetNotifyData;
-				const bool IsLoadSucceed = JsonToStruct::JsonAttributesToUStructWithContainer(InstancedObjectData.JsonObject->Values, Class, InstancedObject, Class, InstancedObject, CheckFlags, SkipFlags, 
-					FCustomImportCallback::CreateLambda([&](const TSharedPtr<FJsonValue>& JsonValue, FProperty* Property, void* OutValue) mutable
-					{
-						if (Property->HasAnyPropertyFlags(CPF_RepNotify))
-						{
-							if (CallRepNotifyIgnorePropertyNames.Contains(Property->GetFName()) == false)
-							{
-								UFunction* RepNotifyFunc = Class->FindFunctionByName(Property->RepNotifyFunc);
-								check(RepNotifyFunc);
-								FGameSerializerNetNotifyData& PropertyAndPreData = AllNetNotifyData.AddDefaulted_GetRef();
-								PropertyAndPreData.Property = Property;
-								PropertyAndPreData.RepNotifyFunc = RepNotifyFunc;
-							}
-						}
-						return JsonObjectIdxToObject(JsonValue, Property, OutValue);
-					}));
+				FRepNotifyImportPolicy ImportPolicy{ { *this }, *RepNotifyTable, InstancedObjectData.AllNetNotifyData };
+				const bool IsLoadSucceed = TJsonToStruct<FRepNotifyImportPolicy>::JsonAttributesToUStructWithContainer(InstancedObjectData.JsonObject->Values, Class, InstancedObject, Class, InstancedObject, CheckFlags, SkipFlags, ImportPolicy);
 				ensure(IsLoadSucceed);
 			}
 		}
 	}
 
+	DECLARE_CYCLE_STAT(TEXT("JsonToStruct_RegisterPendingComponents"), STAT_JsonToStruct_RegisterPendingComponents, STATGROUP_GameSerializer);
+	void FJsonToStruct::RegisterPendingComponents()
+	{
+		GameSerializerStatLog(STAT_JsonToStruct_RegisterPendingComponents);
+
+		for (int32 Idx = 0; Idx < PendingRegisterComponents.Num();)
+		{
+			UActorComponent* Component = PendingRegisterComponents[Idx].Get();
+			if (Component == nullptr || Component->IsRegistered())
+			{
+				PendingRegisterComponents.RemoveAtSwap(Idx, 1, false);
+				continue;
+			}
+			const ULevel* Level = Component->GetComponentLevel();
+			if (Level && Level->bIsVisible == false)
+			{
+				++Idx;
+				continue;
+			}
+			Component->RegisterComponent();
+			PendingRegisterComponents.RemoveAtSwap(Idx, 1, false);
+		}
+	}
+
 	DECLARE_CYCLE_STAT(TEXT("JsonToStruct_ActorFinishSpawning"), STAT_JsonToStruct_ActorFinishSpawning, STATGROUP_GameSerializer);
 	void FJsonToStruct::DynamicActorFinishSpawning()
 	{
@@ -1267,33 +1912,119 @@ namespace GameSerializerCore
 		}
 	}
 
+	TSharedPtr<FGameSerializerExtendData> FJsonToStruct::DecodeExtendData(const FJsonObject& JsonObject, const UScriptStruct*& OutStruct) const
+	{
+		OutStruct = nullptr;
+		const TSharedPtr<FJsonObject>* ExtendDataJsonObject;
+		if (JsonObject.TryGetObjectField(ExtendDataFieldName, ExtendDataJsonObject) == false)
+		{
+			return nullptr;
+		}
+
+		UScriptStruct* Struct = CastChecked<UScriptStruct>(ExternalObjectsArray[-int32(ExtendDataJsonObject->Get()->GetNumberField(ExtendDataTypeFieldName))]);
+		const TSharedRef<FGameSerializerExtendData> ExtendData = ExtendDataArena->Allocate(Struct);
+		FObjectIdxImportPolicy ImportPolicy{ *this };
+		const bool IsLoadSucceed = TJsonToStruct<FObjectIdxImportPolicy>::JsonAttributesToUStructWithContainer(ExtendDataJsonObject->Get()->Values, Struct, &ExtendData.Get(), Struct, &ExtendData.Get(), CheckFlags, SkipFlags, ImportPolicy);
+		ensure(IsLoadSucceed);
+		OutStruct = Struct;
+		return ExtendData;
+	}
+
 	void FJsonToStruct::ExecutePostLoad(UObject* LoadedObject, const FInstancedObjectData& InstancedObjectData) const
 	{
 		const FGameSerializerCallRepNotifyFunc CallRepNotifyFunc(LoadedObject, InstancedObjectData.AllNetNotifyData);
-		const TSharedPtr<FJsonObject>* ExtendDataJsonObject;
-		if (InstancedObjectData.JsonObject->TryGetObjectField(ExtendDataFieldName, ExtendDataJsonObject))
+		FGameSerializerExtendDataContainer DataContainer;
+		if (InstancedObjectData.JsonObject.IsValid())
 		{
-			UScriptStruct* Struct = CastChecked<UScriptStruct>(ExternalObjectsArray[-int32(ExtendDataJsonObject->Get()->GetNumberField(ExtendDataTypeFieldName))]);
-			FGameSerializerExtendData* ExtendData = static_cast<FGameSerializerExtendData*>(FMemory::Malloc(Struct->GetStructureSize()));
-			Struct->InitializeStruct(ExtendData);
-			const bool IsLoadSucceed = JsonToStruct::JsonAttributesToUStructWithContainer(ExtendDataJsonObject->Get()->Values, Struct, ExtendData, Struct, ExtendData, CheckFlags, SkipFlags, FCustomImportCallback::CreateRaw(this, &FJsonToStruct::JsonObjectIdxToObject));
-			ensure(IsLoadSucceed);
-			FGameSerializerExtendDataContainer DataContainer;
+			const UScriptStruct* Struct;
+			DataContainer.ExtendData = DecodeExtendData(*InstancedObjectData.JsonObject, Struct);
 			DataContainer.Struct = Struct;
-			DataContainer.ExtendData = MakeShareable(ExtendData);
-			IGameSerializerInterface::WhenGamePostLoad(LoadedObject, DataContainer, CallRepNotifyFunc);
 		}
 		else
 		{
-			IGameSerializerInterface::WhenGamePostLoad(LoadedObject, FGameSerializerExtendDataContainer(), CallRepNotifyFunc);
+			DataContainer.Struct = InstancedObjectData.ExtendDataStruct;
+			DataContainer.ExtendData = InstancedObjectData.ExtendData;
 		}
+		IGameSerializerInterface::WhenGamePostLoad(LoadedObject, DataContainer, CallRepNotifyFunc);
+	}
+
+	DECLARE_CYCLE_STAT(TEXT("JsonToStruct_CompactForPostLoad"), STAT_JsonToStruct_CompactForPostLoad, STATGROUP_GameSerializer);
+	void FJsonToStruct::CompactForPostLoad()
+	{
+		GameSerializerStatLog(STAT_JsonToStruct_CompactForPostLoad);
+
+		for (FInstancedObjectData& InstancedObjectData : AllInstancedObjectData)
+		{
+			if (InstancedObjectData.JsonObject.IsValid())
+			{
+				if (InstancedObjectData.Object.IsValid())
+				{
+					InstancedObjectData.ExtendData = DecodeExtendData(*InstancedObjectData.JsonObject, InstancedObjectData.ExtendDataStruct);
+				}
+				InstancedObjectData.JsonObject.Reset();
+			}
+		}
+
+		// 根节点只保留对象索引等少量字段，动态对象与其引用的存档数据随之释放
+		WaitParseDynamicObjects();
+		RootJsonObject->RemoveField(DynamicObjectsFieldName);
+		RootJsonObject->RemoveField(DynamicObjectIndexFieldName);
+		DynamicObjectIndex.Empty();
+	}
+
+	SIZE_T FJsonToStruct::GetAllocatedSize() const
+	{
+		SIZE_T Size = ExternalObjectsArray.GetAllocatedSize() + ObjectsArray.GetAllocatedSize() + SpawnedActors.GetAllocatedSize()
+			+ AllInstancedObjectData.GetAllocatedSize() + PendingRegisterComponents.GetAllocatedSize() + DynamicObjectIndex.GetAllocatedSize()
+			+ ExtendDataArena->GetAllocatedSize();
+		for (const FInstancedObjectData& InstancedObjectData : AllInstancedObjectData)
+		{
+			Size += InstancedObjectData.AllNetNotifyData.GetAllocatedSize();
+		}
+		return Size;
 	}
 
 	void FJsonToStruct::RetargetDynamicObjectName(const FString& FieldName, const FName& NewName)
 	{
-		const TSharedPtr<FJsonObject>& JsonDynamicObjects = RootJsonObject->GetObjectField(DynamicObjectsFieldName);
-		const TSharedPtr<FJsonObject>& DynamicObject = JsonDynamicObjects->GetObjectField(FString::FromInt(int32(RootJsonObject->GetNumberField(FieldName))));
-		DynamicObject->SetStringField(ObjectNameFieldName, NewName.ToString());
+		const FObjectIdx ObjectIdx = int32(RootJsonObject->GetNumberField(FieldName));
+		if (DynamicObjectIndex.Num() > 0)
+		{
+			// 只修改索引，对象数据在实例化时才解析
+			const int32 EntryIdx = Algo::BinarySearchBy(DynamicObjectIndex, ObjectIdx, &FDynamicObjectIndexEntry::ObjectIdx);
+			if (ensure(EntryIdx != INDEX_NONE))
+			{
+				FDynamicObjectIndexEntry& IndexEntry = DynamicObjectIndex[EntryIdx];
+				IndexEntry.Name = NewName.ToString();
+				IndexEntry.bRetargeted = true;
+			}
+			return;
+		}
+
+		const TSharedPtr<FJsonObject> DynamicObject = FindDynamicObjectJson(ObjectIdx);
+		if (ensure(DynamicObject.IsValid()))
+		{
+			DynamicObject->SetStringField(ObjectNameFieldName, NewName.ToString());
+		}
+	}
+
+	TSharedPtr<FJsonObject> FJsonToStruct::FindDynamicObjectJson(FObjectIdx ObjectIdx) const
+	{
+		WaitParseDynamicObjects();
+		const TArray<TSharedPtr<FJsonValue>>* DynamicObjectsJsonArray;
+		if (RootJsonObject->TryGetArrayField(DynamicObjectsFieldName, DynamicObjectsJsonArray))
+		{
+			const int32 ArrayIdx = Algo::BinarySearchBy(*DynamicObjectsJsonArray, ObjectIdx, [](const TSharedPtr<FJsonValue>& JsonValue)
+			{
+				return FObjectIdx(JsonValue->AsObject()->GetIntegerField(ObjectIdxFieldName));
+			});
+			return ArrayIdx != INDEX_NONE ? (*DynamicObjectsJsonArray)[ArrayIdx]->AsObject() : nullptr;
+		}
+		const TSharedPtr<FJsonObject>* DynamicObject;
+		if (RootJsonObject->GetObjectField(DynamicObjectsFieldName)->TryGetObjectField(FString::FromInt(ObjectIdx), DynamicObject))
+		{
+			return *DynamicObject;
+		}
+		return nullptr;
 	}
 
 	TArray<UObject*> FJsonToStruct::GetObjects(const FString& FieldName) const
@@ -1314,6 +2045,55 @@ namespace GameSerializerCore
 		return GetObjectByIdx(int32(RootJsonObject->GetNumberField(FieldName)));
 	}
 
+	UObject* FJsonToStruct::FindExistingObject(const FString& ObjectName)
+	{
+		FExistingObjects* ExistingObjects = ExistingObjectsMap.Find(Outer);
+		if (ExistingObjects == nullptr)
+		{
+			ExistingObjects = &ExistingObjectsMap.Add(Outer);
+			ForEachObjectWithOuter(Outer, [ExistingObjects](UObject* Object)
+			{
+				if (Object->IsPendingKill())
+				{
+					ExistingObjects->PendingKillObjects.Add(Object->GetFName(), Object);
+				}
+				else
+				{
+					ExistingObjects->Objects.Add(Object->GetFName(), Object);
+				}
+			}, false);
+		}
+
+		// 名字表中不存在的名字不会有同名对象
+		const FName Name(*ObjectName, FNAME_Find);
+		if (Name.IsNone())
+		{
+			return nullptr;
+		}
+		if (UObject** Object = ExistingObjects->Objects.Find(Name))
+		{
+			return *Object;
+		}
+		UObject* PendingKillObject;
+		if (ExistingObjects->PendingKillObjects.RemoveAndCopyValue(Name, PendingKillObject))
+		{
+			PendingKillObject->Rename(nullptr, GetTransientPackage(), REN_DontCreateRedirectors | REN_ForceNoResetLoaders | REN_NonTransactional | REN_DoNotDirty);
+		}
+		return nullptr;
+	}
+
+	AActor* FJsonToStruct::FindActorByIdentity(const FGuid& Identity) const
+	{
+		const UGameSerializerIdentitySubsystem* IdentitySubsystem = UWorld::GetSubsystem<UGameSerializerIdentitySubsystem>(Outer->GetWorld());
+		AActor* Actor = IdentitySubsystem ? IdentitySubsystem->FindActor(Identity) : nullptr;
+		// 只找回同一关卡中的Actor
+		if (Actor && Actor->GetOuter() == Outer && Actor->IsPendingKill() == false)
+		{
+			return Actor;
+		}
+		return nullptr;
+	}
+
 	UObject* FJsonToStruct::JsonObjectToInstanceObject(const TSharedRef<FJsonObject>& JsonObject, FObjectIdx ObjectIdx)
 	{
 		const FString ObjectName = JsonObject->GetStringField(ObjectNameFieldName);
@@ -1323,22 +2103,21 @@ namespace GameSerializerCore
 			return nullptr;
 		}
 
-		UObject* Object = FindObject<UObject>(Outer, *ObjectName);
-
-		if (Object && Object->IsPendingKill())
-		{
-			Object->Rename(nullptr, GetTransientPackage());
-			Object = nullptr;
-		}
+		FGuid Identity;
+		const bool bHasIdentity = ObjectClass->IsChildOf<AActor>() && TryGetIdentity(*JsonObject, Identity);
+		// 有标识的Actor只通过标识找回，找不到时不按名字匹配，避免绑定到恰好同名的其它Actor
+		UObject* Object = bHasIdentity ? FindActorByIdentity(Identity) : FindExistingObject(ObjectName);
 		
 		if (Object)
 		{
 			// LevelScriptActor的子类在PIE模式下无法做合法性检测，跳过
 			ensure(Object->IsA<ALevelScriptActor>() || Object->IsA(ObjectClass));
-			if (AActor* Actor = Cast<AActor>(Object))
+			// 未记录位置的预放置Actor与关卡中的位置一致
+			AActor* Actor = Cast<AActor>(Object);
+			if (Actor && JsonObject->HasField(ActorTransformFieldName))
 			{
 				FTransform ActorTransform = GetStruct<FTransform>(JsonObject, ActorTransformFieldName);
-				ActorTransform.AddToTranslation(FVector(GameSerializerContext::WorldOffset));
+				ActorTransform.AddToTranslation(FVector(WorldOffset));
 				Actor->SetActorTransform(ActorTransform);
 			}
 		}
@@ -1349,168 +2128,39 @@ namespace GameSerializerCore
 				ULevel* Level = CastChecked<ULevel>(Outer);
 
 				FTransform ActorTransform = GetStruct<FTransform>(JsonObject, ActorTransformFieldName);
-				ActorTransform.AddToTranslation(FVector(GameSerializerContext::WorldOffset));
+				ActorTransform.AddToTranslation(FVector(WorldOffset));
 				
-				FActorSpawnParameters ActorSpawnParameters;
-				ActorSpawnParameters.OverrideLevel = Level;
-				ActorSpawnParameters.bDeferConstruction = true;
-				ActorSpawnParameters.Name = *ObjectName;
-
 				UWorld* World = Level->GetWorld();
-				AActor* Actor = World->SpawnActor<AActor>(ObjectClass, ActorTransform, ActorSpawnParameters);
-				FSpawnedActorData& SpawnedActorData = SpawnedActors.AddDefaulted_GetRef();
-				SpawnedActorData.bNetLoadOnClient = Actor->bNetLoadOnClient;
-				Actor->bNetLoadOnClient = false;
-				SpawnedActorData.SpawnedActor = Actor;
-
-				// Spawn的蓝图Actor需要优先构造Component
-				if (UBlueprintGeneratedClass* ActualBPGC = Cast<UBlueprintGeneratedClass>(ObjectClass))
-				{
-					TArray<const UBlueprintGeneratedClass*> ParentBPClassStack;
-					const bool bErrorFree = UBlueprintGeneratedClass::GetGeneratedClassesHierarchy(ActualBPGC, ParentBPClassStack);
-					if (bErrorFree)
+				// 有标识的Actor使用生成的名字，存档中的名字可能已被关卡中的其它Actor占用
+				const FName SpawnName = bHasIdentity ? NAME_None : FName(*ObjectName);
+				// 开启对象池时优先复用卸载关卡回收的同类型Actor，已经完成构造，不需要FinishSpawning
+				UGameSerializerActorPool* ActorPool = UWorld::GetSubsystem<UGameSerializerActorPool>(World);
+				if (AActor* PooledActor = ActorPool ? ActorPool->Reuse(ObjectClass, Level, SpawnName, ActorTransform) : nullptr)
+				{
+					Object = PooledActor;
+				}
+				else
+				{
+					FActorSpawnParameters ActorSpawnParameters;
+					ActorSpawnParameters.OverrideLevel = Level;
+					ActorSpawnParameters.bDeferConstruction = true;
+					ActorSpawnParameters.Name = SpawnName;
+
+					AActor* Actor = World->SpawnActor<AActor>(ObjectClass, ActorTransform, ActorSpawnParameters);
+					FSpawnedActorData& SpawnedActorData = SpawnedActors.AddDefaulted_GetRef();
+					SpawnedActorData.bNetLoadOnClient = Actor->bNetLoadOnClient;
+					Actor->bNetLoadOnClient = false;
+					SpawnedActorData.SpawnedActor = Actor;
+
+					// Spawn的蓝图Actor需要优先构造Component
+					if (UBlueprintGeneratedClass* ActualBPGC = Cast<UBlueprintGeneratedClass>(ObjectClass))
 					{
 						FGuardValue_Bitfield(World->bIsRunningConstructionScript, true);
-						for (int32 i = ParentBPClassStack.Num() - 1; i >= 0; i--)
-						{
-							const UBlueprintGeneratedClass* CurrentBPGClass = ParentBPClassStack[i];
-							check(CurrentBPGClass);
-							USimpleConstructionScript* SCS = CurrentBPGClass->SimpleConstructionScript;
-							if (SCS)
-							{
-								// 参见
-								// USimpleConstructionScript::ExecuteScriptOnActor
-								// USCS_Node::ExecuteNodeOnActor
-								// 取消了组件注册的流程
-								struct FSCS_NodeInstanceComponent
-								{
-									static UActorComponent* ExecuteNodeOnActor(USCS_Node* RootNode, AActor* Actor, USceneComponent* ParentComponent, const FTransform* RootTransform, const FRotationConversionCache* RootRelativeRotationCache, bool bIsDefaultTransform)
-									{
-										const FName InternalVariableName = RootNode->GetVariableName();
-										
-										check(Actor != nullptr);
-										check((ParentComponent != nullptr && !ParentComponent->IsPendingKill()) || (RootTransform != nullptr)); // must specify either a parent component or a world transform
-
-										// Create a new component instance based on the template
-										UActorComponent* NewActorComp = nullptr;
-										UBlueprintGeneratedClass* ActualBPGC = CastChecked<UBlueprintGeneratedClass>(Actor->GetClass());
-										const FBlueprintCookedComponentInstancingData* ActualComponentTemplateData = ActualBPGC->UseFastPathComponentInstancing() ? RootNode->GetActualComponentTemplateData(ActualBPGC) : nullptr;
-										if (ActualComponentTemplateData && ActualComponentTemplateData->bHasValidCookedData
-											&& ensureMsgf(ActualComponentTemplateData->ComponentTemplateClass != nullptr, TEXT("SCS fast path (%s.%s): Cooked data is valid, but runtime support data is not initialized. Using the slow path instead."), *ActualBPGC->GetName(), *InternalVariableName.ToString()))
-										{
-											// Use cooked instancing data if valid (fast path).
-											NewActorComp = Actor->CreateComponentFromTemplateData(ActualComponentTemplateData, InternalVariableName);
-										}
-										else if (UActorComponent* ActualComponentTemplate = RootNode->GetActualComponentTemplate(ActualBPGC))
-										{
-											NewActorComp = Actor->CreateComponentFromTemplate(ActualComponentTemplate, InternalVariableName);
-										}
-
-										if (NewActorComp != nullptr)
-										{
-											NewActorComp->CreationMethod = EComponentCreationMethod::SimpleConstructionScript;
-
-											// SCS created components are net addressable
-											NewActorComp->SetNetAddressable();
-
-											if (!NewActorComp->HasBeenCreated())
-											{
-												// Call function to notify component it has been created
-												NewActorComp->OnComponentCreated();
-											}
-
-											// Special handling for scene components
-											USceneComponent* NewSceneComp = Cast<USceneComponent>(NewActorComp);
-											if (NewSceneComp != nullptr)
-											{
-												// If NULL is passed in, we are the root, so set transform and assign as RootComponent on Actor, similarly if the 
-												// NewSceneComp is the ParentComponent then we are the root component. This happens when the root component is recycled
-												// by StaticAllocateObject.
-												if (ParentComponent == nullptr || (ParentComponent && ParentComponent->IsPendingKill()) || ParentComponent == NewSceneComp)
-												{
-													FTransform WorldTransform = *RootTransform;
-													if (bIsDefaultTransform)
-													{
-														// Note: We use the scale vector from the component template when spawning (to match what happens with a native root). This
-														// does NOT occur when this component is instanced as part of dynamically spawning a Blueprint class in a cooked build (i.e.
-														// 'bIsDefaultTransform' will be 'false' in that situation). In order to maintain the same behavior between a nativized and
-														// non-nativized cooked build, if this ever changes, we would also need to update the code in AActor::PostSpawnInitialize().
-														WorldTransform.SetScale3D(NewSceneComp->GetRelativeScale3D());
-													}
-
-													if (RootRelativeRotationCache)
-													{	// Enforces using the same rotator as much as possible.
-														NewSceneComp->SetRelativeRotationCache(*RootRelativeRotationCache);
-													}
-
-													NewSceneComp->SetWorldTransform(WorldTransform);
-													Actor->SetRootComponent(NewSceneComp);
-												}
-												// Otherwise, attach to parent component passed in
-												else
-												{
-													NewSceneComp->SetupAttachment(ParentComponent, RootNode->AttachToName);
-												}
-											}
-
-											// If we want to save this to a property, do it here
-											FName VarName = InternalVariableName;
-											if (VarName != NAME_None)
-											{
-												UClass* ActorClass = Actor->GetClass();
-												if (FObjectPropertyBase* Prop = FindFProperty<FObjectPropertyBase>(ActorClass, VarName))
-												{
-													// If it is null we don't really know what's going on, but make it behave as it did before the bug fix
-													if (Prop->PropertyClass == nullptr || NewActorComp->IsA(Prop->PropertyClass))
-													{
-														Prop->SetObjectPropertyValue_InContainer(Actor, NewActorComp);
-													}
-													else
-													{
-														UE_LOG(LogBlueprint, Log, TEXT("ExecuteNodeOnActor: Property '%s' on '%s' is of type '%s'. Could not assign '%s' to it."), *VarName.ToString(), *Actor->GetName(), *Prop->PropertyClass->GetName(), *NewActorComp->GetName());
-													}
-												}
-												else
-												{
-													UE_LOG(LogBlueprint, Log, TEXT("ExecuteNodeOnActor: Couldn't find property '%s' on '%s'"), *VarName.ToString(), *Actor->GetName());
-#if WITH_EDITOR
-													// If we're constructing editable components in the SCS editor, set the component instance corresponding to this node for editing purposes
-													USimpleConstructionScript* SCS = RootNode->GetSCS();
-													if (SCS != nullptr && (SCS->IsConstructingEditorComponents() || SCS->GetComponentEditorActorInstance() == Actor))
-													{
-														RootNode->EditorComponentInstance = NewSceneComp;
-													}
-#endif
-												}
-											}
-
-											// Determine the parent component for our children (it's still our parent if we're a non-scene component)
-											USceneComponent* ParentSceneComponentOfChildren = (NewSceneComp != nullptr) ? NewSceneComp : ParentComponent;
-
-											// If we made a component, go ahead and process our children
-											for (int32 NodeIdx = 0; NodeIdx < RootNode->ChildNodes.Num(); NodeIdx++)
-											{
-												USCS_Node* Node = RootNode->ChildNodes[NodeIdx];
-												check(Node != nullptr);
-												ExecuteNodeOnActor(Node, Actor, ParentSceneComponentOfChildren, nullptr, nullptr, false);
-											}
-										}
-
-										return NewActorComp;
-									}
-								};
-
-								const TArray<USCS_Node*>& Nodes = SCS->GetRootNodes();
-								for (USCS_Node* Node : Nodes)
-								{
-									FSCS_NodeInstanceComponent::ExecuteNodeOnActor(Node, Actor, nullptr, &ActorTransform, nullptr, false);
-								}
-							}
-						}
+						GameSerializerComponentInstancing::InstanceComponents(ActualBPGC, Actor, ActorTransform);
 					}
-				}
 				
-				Object = Actor;
+					Object = Actor;
+				}
 			}
 			else if (ObjectClass->IsChildOf<UActorComponent>())
 			{
@@ -1518,7 +2168,7 @@ namespace GameSerializerCore
 
 				UActorComponent* Component = NewObject<UActorComponent>(Actor, ObjectClass, *ObjectName);
 				Actor->AddOwnedComponent(Component);
-				Component->RegisterComponent();
+				PendingRegisterComponents.Add(Component);
 
 				Object = Component;
 			}
@@ -1528,14 +2178,43 @@ namespace GameSerializerCore
 			}
 		}
 
-		ObjectsArray.SetNumUninitialized(ObjectIdx + 1);
+		// 新Spawn的Actor生成了新的标识，还原为存档中的标识
+		AActor* IdentityActor = bHasIdentity ? Cast<AActor>(Object) : nullptr;
+		if (UGameSerializerIdentityComponent* IdentityComponent = IdentityActor ? UGameSerializerIdentityComponent::Find(IdentityActor) : nullptr)
+		{
+			IdentityComponent->SetIdentity(Identity);
+		}
+
+		// 旧格式没有记录对象总数，按需扩容
+		if (ObjectsArray.IsValidIndex(ObjectIdx) == false)
+		{
+			ObjectsArray.SetNumZeroed(ObjectIdx + 1);
+		}
 		ObjectsArray[ObjectIdx] = Object;
 
-		FInstancedObjectData& InstancedObjectData = AllInstancedObjectData.AddZeroed_GetRef();
+		FInstancedObjectData& InstancedObjectData = AllInstancedObjectData.AddDefaulted_GetRef();
 		InstancedObjectData.Object = Object;
 		InstancedObjectData.JsonObject = JsonObject;
 
 		TGuardValue<UObject*> OuterGuard(Outer, Object);
+		InstanceSubObjects(JsonObject);
+
+		return Object;
+	}
+
+	void FJsonToStruct::InstanceSubObjects(const TSharedRef<FJsonObject>& JsonObject)
+	{
+		const TArray<TSharedPtr<FJsonValue>>* SubObjectsJsonArray;
+		if (JsonObject->TryGetArrayField(SubObjectsFieldName, SubObjectsJsonArray))
+		{
+			for (const TSharedPtr<FJsonValue>& SubObjectJsonValue : *SubObjectsJsonArray)
+			{
+				const TSharedRef<FJsonObject> SubObjectJsonObject = SubObjectJsonValue->AsObject().ToSharedRef();
+				JsonObjectToInstanceObject(SubObjectJsonObject, SubObjectJsonObject->GetIntegerField(ObjectIdxFieldName));
+			}
+			return;
+		}
+
 		const TSharedPtr<FJsonObject>* SubObjectsJsonObject;
 		if (JsonObject->TryGetObjectField(SubObjectsFieldName, SubObjectsJsonObject))
 		{
@@ -1545,22 +2224,25 @@ namespace GameSerializerCore
 				JsonObjectToInstanceObject(Pair.Value->AsObject().ToSharedRef(), SubObjectIdx);
 			}
 		}
-
-		return Object;
 	}
 
 	UObject* FJsonToStruct::GetObjectByIdx(FObjectIdx ObjectIdx) const
 	{
 		if (ObjectIdx >= 0)
 		{
-			UObject* DynamicObject = ObjectsArray[ObjectIdx];
-			return DynamicObject;
+			if (ensureMsgf(ObjectsArray.IsValidIndex(ObjectIdx), TEXT("动态对象索引[%d]越界"), ObjectIdx))
+			{
+				return ObjectsArray[ObjectIdx];
+			}
 		}
 		else
 		{
-			UObject* ExternalObject = ExternalObjectsArray[-ObjectIdx];
-			return ExternalObject;
+			if (ensureMsgf(ExternalObjectsArray.IsValidIndex(-ObjectIdx), TEXT("外部对象索引[%d]越界"), ObjectIdx))
+			{
+				return ExternalObjectsArray[-ObjectIdx];
+			}
 		}
+		return nullptr;
 	}
 
 	bool FJsonToStruct::JsonObjectIdxToObject(const TSharedPtr<FJsonValue>& JsonValue, FProperty* Property, void* OutValue) const
@@ -1580,7 +2262,8 @@ namespace GameSerializerCore
 		if (JsonObject->TryGetObjectField(FieldName, StructJsonObjectPtr))
 		{
 			const TSharedPtr<FJsonObject>& StructJsonObject = *StructJsonObjectPtr;
-			const bool IsLoadSucceed = JsonToStruct::JsonAttributesToUStructWithContainer(StructJsonObject->Values, Struct, Value, Struct, Value, CheckFlags, SkipFlags, FCustomImportCallback::CreateRaw(this, &FJsonToStruct::JsonObjectIdxToObject));
+			FObjectIdxImportPolicy ImportPolicy{ *this };
+			const bool IsLoadSucceed = TJsonToStruct<FObjectIdxImportPolicy>::JsonAttributesToUStructWithContainer(StructJsonObject->Values, Struct, Value, Struct, Value, CheckFlags, SkipFlags, ImportPolicy);
 			ensure(IsLoadSucceed);
 		}
 	}
@@ -1601,4 +2284,155 @@ namespace GameSerializerCore
 		FJsonSerializer::Deserialize(JsonReader, JsonObject);
 		return JsonObject;
 	}
+
+	static TSharedPtr<FJsonObject> UTF8ToJsonObject(TArrayView<const uint8> UTF8Data)
+	{
+		const FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(UTF8Data.GetData()), UTF8Data.Num());
+		return StringToJsonObject(FString(Converter.Length(), Converter.Get()));
+	}
+
+	static void AppendJsonObjectUTF8(const TSharedRef<FJsonObject>& JsonObject, TArray<uint8>& OutData)
+	{
+		const FString JsonString = JsonObjectToString(JsonObject);
+		const FTCHARToUTF8 UTF8String(*JsonString);
+		OutData.Append(reinterpret_cast<const uint8*>(UTF8String.Get()), UTF8String.Length());
+	}
+
+	// 索引格式中的动态对象，首次访问时才从存档数据中解析
+	class FJsonValueLazyObject : public FJsonValue
+	{
+	public:
+		FJsonValueLazyObject(const TSharedRef<const FJsonPayload>& Payload, int32 Offset, int32 Length)
+			: Payload(Payload), Offset(Offset), Length(Length)
+		{
+			Type = EJson::Object;
+		}
+
+		bool TryGetObject(const TSharedPtr<FJsonObject>*& Value) const override
+		{
+			if (bParsed == false)
+			{
+				bParsed = true;
+				FReadScopeLock ViewLock(Payload->ViewLock);
+				const TArrayView<const uint8> PayloadView = Payload->GetView();
+				if (ensure(Offset >= 0 && Length >= 0 && Offset + Length <= PayloadView.Num()))
+				{
+					ParsedJsonObject = UTF8ToJsonObject(PayloadView.Slice(Offset, Length));
+				}
+			}
+			Value = &ParsedJsonObject;
+			return ParsedJsonObject.IsValid();
+		}
+	protected:
+		FString GetType() const override { return TEXT("Object"); }
+	private:
+		TSharedRef<const FJsonPayload> Payload;
+		int32 Offset;
+		int32 Length;
+		mutable bool bParsed = false;
+		mutable TSharedPtr<FJsonObject> ParsedJsonObject;
+	};
+
+	DECLARE_CYCLE_STAT(TEXT("GameSerializerCore_EncodeJsonPayload"), STAT_GameSerializerCore_EncodeJsonPayload, STATGROUP_GameSerializer);
+	TArray<uint8> EncodeJsonPayload(const TSharedRef<FJsonObject>& JsonObject)
+	{
+		GameSerializerStatLog(STAT_GameSerializerCore_EncodeJsonPayload);
+
+		TArray<uint8> Payload;
+		const TArray<TSharedPtr<FJsonValue>>* DynamicObjectsJsonArray;
+		if (JsonObject->TryGetArrayField(DynamicObjectsFieldName, DynamicObjectsJsonArray) == false)
+		{
+			AppendJsonObjectUTF8(JsonObject, Payload);
+			return Payload;
+		}
+
+		TArray<uint8> DynamicObjectsData;
+		TArray<TSharedPtr<FJsonValue>> IndexJsonArray;
+		IndexJsonArray.Reserve(DynamicObjectsJsonArray->Num());
+		for (const TSharedPtr<FJsonValue>& DynamicObjectJsonValue : *DynamicObjectsJsonArray)
+		{
+			const TSharedRef<FJsonObject> DynamicObjectJsonObject = DynamicObjectJsonValue->AsObject().ToSharedRef();
+			const int32 Offset = DynamicObjectsData.Num();
+			AppendJsonObjectUTF8(DynamicObjectJsonObject, DynamicObjectsData);
+
+			TArray<TSharedPtr<FJsonValue>> EntryJsonArray;
+			EntryJsonArray.SetNum(EDynamicObjectIndexEntry::Num);
+			EntryJsonArray[EDynamicObjectIndexEntry::ObjectIdx] = MakeShared<FJsonValueNumber>(DynamicObjectJsonObject->GetIntegerField(ObjectIdxFieldName));
+			EntryJsonArray[EDynamicObjectIndexEntry::ClassIdx] = MakeShared<FJsonValueNumber>(DynamicObjectJsonObject->GetIntegerField(ObjectClassFieldName));
+			EntryJsonArray[EDynamicObjectIndexEntry::Name] = MakeShared<FJsonValueString>(DynamicObjectJsonObject->GetStringField(ObjectNameFieldName));
+			EntryJsonArray[EDynamicObjectIndexEntry::Offset] = MakeShared<FJsonValueNumber>(Offset);
+			EntryJsonArray[EDynamicObjectIndexEntry::Length] = MakeShared<FJsonValueNumber>(DynamicObjectsData.Num() - Offset);
+			IndexJsonArray.Add(MakeShared<FJsonValueArray>(EntryJsonArray));
+		}
+
+		// 浅拷贝根节点，动态对象替换为索引
+		const TSharedRef<FJsonObject> IndexedRootJsonObject = MakeShared<FJsonObject>();
+		IndexedRootJsonObject->Values = JsonObject->Values;
+		IndexedRootJsonObject->Values.Remove(DynamicObjectsFieldName);
+		IndexedRootJsonObject->SetArrayField(DynamicObjectIndexFieldName, IndexJsonArray);
+
+		TArray<uint8> RootData;
+		AppendJsonObjectUTF8(IndexedRootJsonObject, RootData);
+
+		const uint32 Magic = IndexedPayloadMagic;
+		const uint32 RootSize = RootData.Num();
+		Payload.Reserve(sizeof(Magic) + sizeof(RootSize) + RootData.Num() + DynamicObjectsData.Num());
+		Payload.Append(reinterpret_cast<const uint8*>(&Magic), sizeof(Magic));
+		Payload.Append(reinterpret_cast<const uint8*>(&RootSize), sizeof(RootSize));
+		Payload.Append(RootData);
+		Payload.Append(DynamicObjectsData);
+		return Payload;
+	}
+
+	DECLARE_CYCLE_STAT(TEXT("GameSerializerCore_DecodeJsonPayload"), STAT_GameSerializerCore_DecodeJsonPayload, STATGROUP_GameSerializer);
+	TSharedPtr<FJsonObject> DecodeJsonPayload(const TSharedRef<const FJsonPayload>& Payload)
+	{
+		GameSerializerStatLog(STAT_GameSerializerCore_DecodeJsonPayload);
+
+		FReadScopeLock ViewLock(Payload->ViewLock);
+		const TArrayView<const uint8> PayloadView = Payload->GetView();
+		uint32 Magic = 0;
+		uint32 RootSize = 0;
+		constexpr int32 HeaderSize = sizeof(Magic) + sizeof(RootSize);
+		if (PayloadView.Num() >= HeaderSize)
+		{
+			FMemory::Memcpy(&Magic, PayloadView.GetData(), sizeof(Magic));
+		}
+		if (Magic != IndexedPayloadMagic)
+		{
+			return UTF8ToJsonObject(PayloadView);
+		}
+
+		FMemory::Memcpy(&RootSize, PayloadView.GetData() + sizeof(Magic), sizeof(RootSize));
+		if (ensure(HeaderSize + int64(RootSize) <= PayloadView.Num()) == false)
+		{
+			return nullptr;
+		}
+		const TSharedPtr<FJsonObject> RootJsonObject = UTF8ToJsonObject(PayloadView.Slice(HeaderSize, RootSize));
+		if (RootJsonObject.IsValid() == false)
+		{
+			return nullptr;
+		}
+
+		const int32 DynamicObjectsOffset = HeaderSize + RootSize;
+		const TArray<TSharedPtr<FJsonValue>>* IndexJsonArray;
+		if (RootJsonObject->TryGetArrayField(DynamicObjectIndexFieldName, IndexJsonArray))
+		{
+			TArray<TSharedPtr<FJsonValue>> DynamicObjectsJsonArray;
+			DynamicObjectsJsonArray.Reserve(IndexJsonArray->Num());
+			for (const TSharedPtr<FJsonValue>& EntryJsonValue : *IndexJsonArray)
+			{
+				const TArray<TSharedPtr<FJsonValue>>& EntryJsonArray = EntryJsonValue->AsArray();
+				if (ensure(EntryJsonArray.Num() == EDynamicObjectIndexEntry::Num) == false)
+				{
+					return nullptr;
+				}
+				const int32 Offset = DynamicObjectsOffset + int32(EntryJsonArray[EDynamicObjectIndexEntry::Offset]->AsNumber());
+				const int32 Length = int32(EntryJsonArray[EDynamicObjectIndexEntry::Length]->AsNumber());
+				DynamicObjectsJsonArray.Add(MakeShared<FJsonValueLazyObject>(Payload, Offset, Length));
+			}
+			RootJsonObject->SetArrayField(DynamicObjectsFieldName, DynamicObjectsJsonArray);
+		}
+		return RootJsonObject;
+	}
 }
@@ -2,7 +2,9 @@
 
 
 #include "GameSerializerExtendData.h"
+#include <Misc/ScopeExit.h>
 
+#include "GameSerializerClassCache.h"
 #include "GameSerializerInterface.h"
 
 
@@ -10,57 +12,159 @@ namespace GameSerializerExtendDataFactory
 {
 	TMap<UClass*, TSharedRef<FGameSerializerExtendDataFactory>> Factory;
 
-	FGameSerializerExtendDataFactory* FindFactory(UObject* Instance)
+	struct FResolvedFactory
 	{
-		for (UClass* Class = Instance->GetClass(); Class; Class = Class->GetSuperClass())
+		TWeakObjectPtr<const UClass> Class;
+		// 为空时该类型没有工厂
+		FGameSerializerExtendDataFactory* Factory;
+	};
+	TMap<const UClass*, FResolvedFactory> ResolvedFactories;
+
+	FGameSerializerExtendDataFactory* FindFactory(const UClass* Class)
+	{
+		FResolvedFactory& ResolvedFactory = ResolvedFactories.FindOrAdd(Class);
+		// 类型被回收后地址可能被新的类型复用
+		if (ResolvedFactory.Class.Get() != Class)
 		{
-			if (TSharedRef<FGameSerializerExtendDataFactory>* FindFactory = Factory.Find(Class))
+			ResolvedFactory.Class = Class;
+			ResolvedFactory.Factory = nullptr;
+			for (const UClass* TestClass = Class; TestClass; TestClass = TestClass->GetSuperClass())
 			{
-				return &FindFactory->Get();
+				if (TSharedRef<FGameSerializerExtendDataFactory>* FindFactory = Factory.Find(TestClass))
+				{
+					ResolvedFactory.Factory = &FindFactory->Get();
+					break;
+				}
 			}
 		}
-		return nullptr;
+		return ResolvedFactory.Factory;
+	}
+
+	void InvalidateResolvedFactories()
+	{
+		ResolvedFactories.Empty();
 	}
 }
 
-void FGameSerializerCallRepNotifyFunc::CallRepNotifyFunc() const
+FGameSerializerRepNotifyTable::FGameSerializerRepNotifyTable(UClass* InClass)
+	: Class(InClass)
 {
-#if DO_CHECK
-	ensureAlwaysMsgf(bCalled == false, TEXT("[%s] FGameSerializerCallRepNotifyFunc::CallRepNotifyFunc only can call once."), *InstancedObject->GetName());
-	bCalled = true;
-#endif
-	
-	UClass* Class = InstancedObject->GetClass();
-	const UObject* CDO = Class->GetDefaultObject();
+	TArray<FName> CallRepNotifyIgnorePropertyNames;
+	UObject* CDO = InClass->GetDefaultObject();
+	if (GameSerializerClassCache::Get(InClass).bGameSerializerInterface)
+	{
+		CallRepNotifyIgnorePropertyNames = IGameSerializerInterface::GetCallRepNotifyIgnorePropertyNames(CDO);
+	}
 
-	TGuardValue<bool> IsGameSerializerCallGuard(bIsGameSerializerCall, true);
-	
-	for (const FGameSerializerNetNotifyData& NetNotifyData : *NetNotifyDatas)
+	for (TFieldIterator<FProperty> It(InClass); It; ++It)
 	{
-		UFunction* RepNotifyFunc = NetNotifyData.RepNotifyFunc;
+		FProperty* Property = *It;
+		if (Property->HasAnyPropertyFlags(CPF_RepNotify) == false)
+		{
+			continue;
+		}
+
+		FEntry& Entry = Entries.Add(Property);
+		Entry.bIgnored = CallRepNotifyIgnorePropertyNames.Contains(Property->GetFName());
+		if (Entry.bIgnored)
+		{
+			continue;
+		}
 
-		FMemMark Mark(FMemStack::Get());
-		uint8* Params = new(FMemStack::Get(), MEM_Zeroed, RepNotifyFunc->ParmsSize)uint8;
+		UFunction* RepNotifyFunc = InClass->FindFunctionByName(Property->RepNotifyFunc);
+		check(RepNotifyFunc);
+		Entry.RepNotifyFunc = RepNotifyFunc;
+		if (RepNotifyFunc->ParmsSize > 0)
+		{
+			Entry.Params = static_cast<uint8*>(FMemory::Malloc(RepNotifyFunc->ParmsSize, RepNotifyFunc->GetMinAlignment()));
+			FMemory::Memzero(Entry.Params, RepNotifyFunc->ParmsSize);
+			for (TFieldIterator<FProperty> ParamItr(RepNotifyFunc); ParamItr && ParamItr->HasAnyPropertyFlags(CPF_Parm); ++ParamItr)
+			{
+				ParamItr->InitializeValue_InContainer(Entry.Params);
+			}
 
-		if (RepNotifyFunc->NumParms == 1)
+			if (RepNotifyFunc->NumParms == 1)
+			{
+				TFieldIterator<FProperty> Itr(RepNotifyFunc);
+				Itr->CopyCompleteValue(Itr->ContainerPtrToValuePtr<void>(Entry.Params), Property->ContainerPtrToValuePtr<void>(CDO));
+			}
+		}
+	}
+}
+
+FGameSerializerRepNotifyTable::~FGameSerializerRepNotifyTable()
+{
+	// 类型已被回收时参数的属性也已失效，只释放内存
+	const bool bCanDestroyParams = Class.IsValid();
+	for (const TPair<const FProperty*, FEntry>& Pair : Entries)
+	{
+		const FEntry& Entry = Pair.Value;
+		if (Entry.Params == nullptr)
+		{
+			continue;
+		}
+		if (bCanDestroyParams)
 		{
-			FField* FirstParam = RepNotifyFunc->ChildProperties;
-			check(FirstParam->GetClass() == FirstParam->GetClass());
+			for (TFieldIterator<FProperty> ParamItr(Entry.RepNotifyFunc); ParamItr && ParamItr->HasAnyPropertyFlags(CPF_Parm); ++ParamItr)
+			{
+				ParamItr->DestroyValue_InContainer(Entry.Params);
+			}
+		}
+		FMemory::Free(Entry.Params);
+	}
+}
 
-			TFieldIterator<FProperty> Itr(RepNotifyFunc);
-			Itr->CopyCompleteValue(Itr->ContainerPtrToValuePtr<void>(Params), NetNotifyData.Property->ContainerPtrToValuePtr<void>(CDO));
+namespace GameSerializerRepNotifyTable
+{
+	TMap<const UClass*, TSharedRef<const FGameSerializerRepNotifyTable>> Tables;
+
+	TSharedRef<const FGameSerializerRepNotifyTable> Get(UClass* Class)
+	{
+		check(IsInGameThread());
+		if (const TSharedRef<const FGameSerializerRepNotifyTable>* Table = Tables.Find(Class))
+		{
+			// 类型被回收后地址可能被新的类型复用
+			if ((*Table)->Class.Get() == Class)
+			{
+				return *Table;
+			}
 		}
+		return Tables.Add(Class, MakeShared<const FGameSerializerRepNotifyTable>(Class));
+	}
 
-		InstancedObject->ProcessEvent(RepNotifyFunc, Params);
+	void Flush()
+	{
+		Tables.Empty();
+	}
+}
+
+// 每个线程独立，其他线程的读档不影响判断
+static thread_local int32 GameSerializerCallDepth = 0;
 
-		Mark.Pop();
+void FGameSerializerCallRepNotifyFunc::CallRepNotifyFunc() const
+{
+#if DO_CHECK
+	ensureAlwaysMsgf(bCalled == false, TEXT("[%s] FGameSerializerCallRepNotifyFunc::CallRepNotifyFunc only can call once."), *InstancedObject->GetName());
+	bCalled = true;
+#endif
+
+	// RepNotify中可能再次触发读档的RepNotify，按调用深度判断
+	GameSerializerCallDepth += 1;
+	ON_SCOPE_EXIT
+	{
+		GameSerializerCallDepth -= 1;
+	};
+	
+	for (const FGameSerializerNetNotifyData& NetNotifyData : *NetNotifyDatas)
+	{
+		// 参数由类型的RepNotify表持有，RepNotify的参数不会被写回，可以直接复用
+		InstancedObject->ProcessEvent(NetNotifyData.RepNotifyFunc, NetNotifyData.Params);
 	}
 }
 
-bool FGameSerializerCallRepNotifyFunc::bIsGameSerializerCall = false;
 bool FGameSerializerCallRepNotifyFunc::IsGameSerializerCall()
 {
-	return bIsGameSerializerCall;
+	return GameSerializerCallDepth > 0;
 }
 
 FGameSerializerExtendDataContainer UGameSerializerExtendDataFunctionLibrary::DefaultPreGameSave(UObject* Instance)
@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameSerializerIdentity.h"
+#include <Engine/World.h>
+#include <GameFramework/Actor.h>
+
+#include "GameSerializer_Log.h"
+
+UGameSerializerIdentityComponent::UGameSerializerIdentityComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UGameSerializerIdentityComponent::SetIdentity(const FGuid& NewIdentity)
+{
+	if (Identity == NewIdentity)
+	{
+		return;
+	}
+	if (IsRegistered())
+	{
+		if (UGameSerializerIdentitySubsystem* IdentitySubsystem = UWorld::GetSubsystem<UGameSerializerIdentitySubsystem>(GetWorld()))
+		{
+			IdentitySubsystem->Unregister(Identity, GetOwner());
+			IdentitySubsystem->Register(NewIdentity, GetOwner());
+		}
+	}
+	Identity = NewIdentity;
+}
+
+void UGameSerializerIdentityComponent::OnComponentCreated()
+{
+	Super::OnComponentCreated();
+
+	if (Identity.IsValid() == false)
+	{
+		Identity = FGuid::NewGuid();
+	}
+}
+
+void UGameSerializerIdentityComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	if (Identity.IsValid())
+	{
+		if (UGameSerializerIdentitySubsystem* IdentitySubsystem = UWorld::GetSubsystem<UGameSerializerIdentitySubsystem>(GetWorld()))
+		{
+			IdentitySubsystem->Register(Identity, GetOwner());
+		}
+	}
+}
+
+void UGameSerializerIdentityComponent::OnUnregister()
+{
+	if (Identity.IsValid())
+	{
+		if (UGameSerializerIdentitySubsystem* IdentitySubsystem = UWorld::GetSubsystem<UGameSerializerIdentitySubsystem>(GetWorld()))
+		{
+			IdentitySubsystem->Unregister(Identity, GetOwner());
+		}
+	}
+
+	Super::OnUnregister();
+}
+
+#if WITH_EDITOR
+void UGameSerializerIdentityComponent::PostEditImport()
+{
+	Super::PostEditImport();
+
+	// 编辑器中复制粘贴的Actor需要新的标识
+	Identity = FGuid::NewGuid();
+}
+#endif
+
+void UGameSerializerIdentityComponent::PostDuplicate(bool bDuplicateForPIE)
+{
+	Super::PostDuplicate(bDuplicateForPIE);
+
+	// PIE复制的世界需要保持与编辑器中相同的标识
+	if (bDuplicateForPIE == false)
+	{
+		Identity = FGuid::NewGuid();
+	}
+}
+
+UGameSerializerIdentityComponent* UGameSerializerIdentityComponent::Find(const AActor* Actor)
+{
+	return Actor->FindComponentByClass<UGameSerializerIdentityComponent>();
+}
+
+bool UGameSerializerIdentitySubsystem::DoesSupportWorldType(EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+AActor* UGameSerializerIdentitySubsystem::FindActor(const FGuid& Identity) const
+{
+	const TWeakObjectPtr<AActor>* Actor = IdentityIndex.Find(Identity);
+	return Actor ? Actor->Get() : nullptr;
+}
+
+void UGameSerializerIdentitySubsystem::Register(const FGuid& Identity, AActor* Actor)
+{
+	TWeakObjectPtr<AActor>& RegisteredActor = IdentityIndex.FindOrAdd(Identity);
+	ensureMsgf(RegisteredActor.IsValid() == false || RegisteredActor == Actor, TEXT("[%s]与[%s]的标识[%s]重复"), *GetNameSafe(RegisteredActor.Get()), *Actor->GetName(), *Identity.ToString());
+	RegisteredActor = Actor;
+}
+
+void UGameSerializerIdentitySubsystem::Unregister(const FGuid& Identity, const AActor* Actor)
+{
+	const TWeakObjectPtr<AActor>* RegisteredActor = IdentityIndex.Find(Identity);
+	// 标识重复时不能移除另一个Actor的记录
+	if (RegisteredActor && (RegisteredActor->IsValid() == false || RegisteredActor->Get() == Actor))
+	{
+		IdentityIndex.Remove(Identity);
+	}
+}
@@ -3,6 +3,7 @@
 
 #include "GameSerializerInterface.h"
 
+#include "GameSerializerClassCache.h"
 #include "GameSerializer_Log.h"
 
 UObject* IGameSerializerInterface::GetGameSerializedOuter() const
@@ -12,9 +13,10 @@ UObject* IGameSerializerInterface::GetGameSerializedOuter() const
 
 UObject* IGameSerializerInterface::GetGameSerializedOuter(const UObject* Obj)
 {
-	if (const IGameSerializerInterface* GameSerializerInterface = Cast<IGameSerializerInterface>(Obj))
+	const FGameSerializerClassCapabilities& Capabilities = GameSerializerClassCache::Get(Obj->GetClass());
+	if (Capabilities.GameSerializerInterfaceOffset != INDEX_NONE)
 	{
-		return GameSerializerInterface->GetGameSerializedOuter();
+		return Capabilities.GetNativeInterface(Obj)->GetGameSerializedOuter();
 	}
 	return Obj->GetOuter();
 }
@@ -26,7 +28,7 @@ FGameSerializerExtendDataContainer IGameSerializerInterface::WhenGamePreSave_Imp
 
 FGameSerializerExtendDataContainer IGameSerializerInterface::WhenGamePreSave(UObject* Obj)
 {
-	if (Obj->Implements<UGameSerializerInterface>())
+	if (GameSerializerClassCache::Get(Obj->GetClass()).bGameSerializerInterface)
 	{
 		FEditorScriptExecutionGuard EditorScriptExecutionGuard;
 		FGameSerializerExtendDataContainer ExtendDataContainer = Execute_WhenGamePreSave(Obj);
@@ -40,7 +42,7 @@ FGameSerializerExtendDataContainer IGameSerializerInterface::WhenGamePreSave(UOb
 
 void IGameSerializerInterface::WhenGamePostLoad(UObject* Obj, const FGameSerializerExtendDataContainer& ExtendData, const FGameSerializerCallRepNotifyFunc& CallRepNotifyFunc)
 {
-	if (Obj->Implements<UGameSerializerInterface>())
+	if (GameSerializerClassCache::Get(Obj->GetClass()).bGameSerializerInterface)
 	{
 		FEditorScriptExecutionGuard EditorScriptExecutionGuard;
 		Execute_WhenGamePostLoad(Obj, ExtendData, CallRepNotifyFunc);
@@ -84,7 +86,7 @@ void IActorGameSerializerInterface::WhenGameInit(AActor* Actor)
 	Execute_WhenGameInit(Actor);
 	for (UActorComponent* Component : Actor->GetComponents())
 	{
-		if (Component->Implements<UComponentGameSerializerInterface>())
+		if (GameSerializerClassCache::Get(Component->GetClass()).bComponentInterface)
 		{
 			IComponentGameSerializerInterface::WhenGameInit(Component);
 		}
@@ -102,10 +104,40 @@ AActor* IActorGameSerializerInterface::GetGameSerializedOwner_Implementation() c
 	return CastChecked<AActor>(this)->GetOwner();
 }
 
+bool IActorGameSerializerInterface::CanGameSerializedInLevel(const AActor* Actor)
+{
+	const FGameSerializerClassCapabilities& Capabilities = GameSerializerClassCache::Get(Actor->GetClass());
+	if (Capabilities.bNativeCanGameSerializedInLevel)
+	{
+		return Capabilities.GetNativeActorInterface(Actor)->CanGameSerializedInLevel_Implementation();
+	}
+	return Execute_CanGameSerializedInLevel(Actor);
+}
+
+bool IActorGameSerializerInterface::IsGameSerializedInLevel(const AActor* Actor)
+{
+	return GameSerializerClassCache::Get(Actor->GetClass()).bActorInterface && CanGameSerializedInLevel(Actor);
+}
+
+int32 IActorGameSerializerInterface::GetGameSerializePriority(const AActor* Actor)
+{
+	const FGameSerializerClassCapabilities& Capabilities = GameSerializerClassCache::Get(Actor->GetClass());
+	if (Capabilities.bNativeGetGameSerializePriority)
+	{
+		return Capabilities.GetNativeActorInterface(Actor)->GetGameSerializePriority_Implementation();
+	}
+	return Execute_GetGameSerializePriority(Actor);
+}
+
 AActor* IActorGameSerializerInterface::GetGameSerializedOwner(const AActor* Actor)
 {
-	if (Actor->Implements<UActorGameSerializerInterface>())
+	const FGameSerializerClassCapabilities& Capabilities = GameSerializerClassCache::Get(Actor->GetClass());
+	if (Capabilities.bActorInterface)
 	{
+		if (Capabilities.bNativeGetGameSerializedOwner)
+		{
+			return Capabilities.GetNativeActorInterface(Actor)->GetGameSerializedOwner_Implementation();
+		}
 		FEditorScriptExecutionGuard EditorScriptExecutionGuard;
 		return Execute_GetGameSerializedOwner(Actor);
 	}
@@ -119,7 +151,7 @@ void IActorGameSerializerInterface::SetGameSerializedOwner_Implementation(AActor
 
 void IActorGameSerializerInterface::SetGameSerializedOwner(AActor* Actor, AActor* GameSerializedOwner)
 {
-	if (Actor->Implements<UActorGameSerializerInterface>())
+	if (GameSerializerClassCache::Get(Actor->GetClass()).bActorInterface)
 	{
 		FEditorScriptExecutionGuard EditorScriptExecutionGuard;
 		Execute_SetGameSerializedOwner(Actor, GameSerializedOwner);
@@ -3,10 +3,13 @@
 
 #include "GameSerializerManager.h"
 #include <PlatformFeatures.h>
+#include <Async/Async.h>
+#include <Hash/CityHash.h>
 #include <SaveGameSystem.h>
 #include <GameFramework/PlayerState.h>
 #include <GameFramework/GameModeBase.h>
 #include <Engine/LevelStreaming.h>
+#include <Streaming/LevelStreamingDelegates.h>
 #include <GameFramework/GameStateBase.h>
 #include <GameFramework/WorldSettings.h>
 #if WITH_EDITOR
@@ -14,8 +17,12 @@
 #endif
 
 #include "GameSerializer_Log.h"
+#include "GameSerializerActorPool.h"
+#include "GameSerializerClassCache.h"
 #include "GameSerializerCore.h"
 #include "GameSerializerInterface.h"
+#include "GameSerializerSettings.h"
+#include "GameSerializerStorage.h"
 
 namespace JsonFieldName
 {
@@ -70,28 +77,14 @@ void UGameSerializerLevelStreamingLambda::WhenLevelLoaded()
 	OnLevelLoaded.Execute(CastChecked<ULevelStreaming>(GetOuter())->GetLoadedLevel());
 }
 
-bool UGameSerializerWorldSubsystem::DoesSupportWorldType(EWorldType::Type WorldType) const
+bool UGameSerializerWorldSubsystem::ShouldCreateSubsystem(UObject* Outer) const
 {
-	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
-}
-
-void UGameSerializerWorldSubsystem::UpdateStreamingState()
-{
-	Super::UpdateStreamingState();
-
-	if (const UGameInstance* GameInstance = GetWorld()->GetGameInstance())
-	{
-		if (UGameSerializerManager* GameSerializerManager = GameInstance->GetSubsystem<UGameSerializerManager>())
-		{
-			GameSerializerManager->UpdateLevelStreamingData();
-		}
-	}
+	return false;
 }
 
 UGameSerializerManager::UGameSerializerManager()
 	: bIsEnable(false)
 	, bInvokeLoadGame(true)
-	, bShouldInitSpawnActor(true)
 {
 	
 }
@@ -120,6 +113,14 @@ void UGameSerializerManager::Deinitialize()
 		SerializeWorldWhenRemoved(World);
 	}
 	DisableSystem();
+	ResetPendingLevelLoads();
+	FlushPendingWrites();
+	SlotContainer.Reset();
+	bSlotContainerOpenFailed = false;
+	PayloadCache.Reset();
+	SavedContentHashes.Empty();
+	SaveGameWrites.Empty();
+	PendingSaveGameNum = 0;
 }
 
 void UGameSerializerManager::EnableSystem()
@@ -161,6 +162,50 @@ void UGameSerializerManager::EnableSystem()
 			LoadOrInitLevel(Level);
 		});
 
+		// 对象池需要在EndPlay之前回收Actor，储存关卡后再回收
+		OnPreLevelRemoved_DelegateHandle = FWorldDelegates::PreLevelRemovedFromWorld.AddWeakLambda(this, [this](ULevel* Level, UWorld* World)
+		{
+			UGameSerializerActorPool* ActorPool = UWorld::GetSubsystem<UGameSerializerActorPool>(World);
+			if (ActorPool == nullptr || Level == nullptr || World != LoadedWorld || LoadedLevels.Contains(Level) == false)
+			{
+				return;
+			}
+
+			LoadedLevels.Remove(Level);
+			SerializeLevel(Level);
+			LevelBaselinesMap.Remove(Level);
+			ActorPool->ParkLevelActors(Level);
+		});
+
+		OnLevelStreamingStateChanged_DelegateHandle = FLevelStreamingDelegates::OnLevelStreamingStateChanged.AddWeakLambda(this, [this](UWorld* World, const ULevelStreaming* LevelStreaming, ULevel* LevelIfLoaded, ELevelStreamingState PreviousState, ELevelStreamingState NewState)
+		{
+			if (bInvokeLoadGame == false || World != LoadedWorld)
+			{
+				return;
+			}
+
+			ULevelStreaming* MutableLevelStreaming = const_cast<ULevelStreaming*>(LevelStreaming);
+			if (NewState == ELevelStreamingState::Removed)
+			{
+				UnregisterLevelStreaming(MutableLevelStreaming);
+				return;
+			}
+			if (LevelStreamingLambdas.Contains(MutableLevelStreaming) == false)
+			{
+				RegisterLevelStreaming(MutableLevelStreaming);
+				// 同步加载的关卡在第一次状态变化时可能已经载入完毕
+				if (LevelIfLoaded && (NewState == ELevelStreamingState::LoadedNotVisible || NewState == ELevelStreamingState::MakingVisible))
+				{
+					WhenStreamingLevelLoaded(LevelIfLoaded);
+				}
+			}
+			// 关卡开始加入世界前完成剩余的读档阶段，保证组件注册与BeginPlay时已经是存档的状态
+			if (LevelIfLoaded && NewState == ELevelStreamingState::MakingVisible)
+			{
+				FinishPendingLevelLoad(LevelIfLoaded);
+			}
+		});
+
 		OnWorldCleanup_DelegateHandle = FWorldDelegates::OnWorldCleanup.AddWeakLambda(this, [this](UWorld* World, bool /*bSessionEnded*/, bool /*bCleanupResources*/)
 		{
 			if (World != LoadedWorld || ensure(IsArchiveWorld(World)) == false)
@@ -198,6 +243,8 @@ void UGameSerializerManager::DisableSystem()
 	{
 		bIsEnable = false;
 		FWorldDelegates::LevelAddedToWorld.Remove(OnLevelAdd_DelegateHandle);
+		FWorldDelegates::PreLevelRemovedFromWorld.Remove(OnPreLevelRemoved_DelegateHandle);
+		FLevelStreamingDelegates::OnLevelStreamingStateChanged.Remove(OnLevelStreamingStateChanged_DelegateHandle);
 		FWorldDelegates::OnWorldCleanup.Remove(OnWorldCleanup_DelegateHandle);
 		FGameModeEvents::GameModeInitializedEvent.Remove(OnGameModeInitialized_DelegateHandle);
 #if WITH_EDITOR
@@ -219,74 +266,313 @@ bool UGameSerializerManager::IsArchiveWorld(UWorld* World) const
 
 TOptional<TSharedRef<FJsonObject>> UGameSerializerManager::TryLoadJsonObject(UWorld* World, const FString& Category, const FString& FileName)
 {
-	ISaveGameSystem* SaveSystem = IPlatformFeaturesModule::Get().GetSaveGameSystem();
-	if (ensure(SaveSystem))
+	const FString FilePath = FPaths::Combine(Category, FileName);
+
+	const TSharedPtr<GameSerializerStorage::FPayloadCache> Cache = GetPayloadCache();
+	TSharedPtr<const GameSerializerCore::FJsonPayload> Payload = Cache ? Cache->Find({ FilePath, UserIndex }) : nullptr;
+	const bool bCacheHit = Payload.IsValid();
+	if (bCacheHit)
 	{
-		const FString FilePath = FPaths::Combine(Category, FileName);
-		if (SaveSystem->DoesSaveGameExist(*FilePath, UserIndex))
+		UE_LOG(GameSerializer_Log, Verbose, TEXT("存档[%s]从缓存读取"), *FilePath);
+	}
+	else if (const TSharedPtr<GameSerializerStorage::FSaveSlotContainer> Container = GetSlotContainer(); Container && (Container->Contains(FilePath) || Container->IsLegacyImported()))
+	{
+		// 容器内的存档只通过目录查找，单独的存档文件导入后目录中没有的存档不存在
+		Payload = Container->Read(FilePath);
+	}
+	else
+	{
+		// 未使用容器或单独的存档文件未能全部导入时，从单独的存档文件读取
+		if (GetDefault<UGameSerializerSettings>()->bUseMappedFileReads)
 		{
-			TArray<uint8> BinaryArray;
-			if (SaveSystem->LoadGame(false, *FilePath, UserIndex, BinaryArray))
+			Payload = GameSerializerStorage::DecodeMappedSaveFile(GameSerializerStorage::GetSaveGameFilePath(FilePath));
+		}
+
+		if (Payload.IsValid() == false)
+		{
+			ISaveGameSystem* SaveSystem = IPlatformFeaturesModule::Get().GetSaveGameSystem();
+			if (ensure(SaveSystem) && SaveSystem->DoesSaveGameExist(*FilePath, UserIndex))
 			{
-				uint8* CompressedBuffer = BinaryArray.GetData();
-				int32 CompressionHeader = 0;
-				const int32 CompressionHeaderSize = sizeof(CompressionHeader);
-
-				FMemory::Memcpy(&CompressionHeader, CompressedBuffer, CompressionHeaderSize);
-				CompressedBuffer += CompressionHeaderSize;
-
-				const int32 CompressedSize = BinaryArray.Num() - CompressionHeaderSize;
-				const int32 UncompressedSize = CompressionHeader;
-				TArray<uint8> UncompressedBuffer;
-				UncompressedBuffer.AddUninitialized(UncompressedSize);
-
-				FCompression::UncompressMemory(NAME_Zlib, UncompressedBuffer.GetData(), UncompressedSize, CompressedBuffer, CompressedSize);
-				
-				UncompressedBuffer.Add(0);
-				const FString JsonString = FString(UTF8_TO_TCHAR(UncompressedBuffer.GetData()));
-				const TSharedPtr<FJsonObject> JsonObject = GameSerializerCore::StringToJsonObject(JsonString);
-				if (ensure(JsonObject.IsValid()))
+				TArray<uint8> BinaryArray;
+				if (SaveSystem->LoadGame(false, *FilePath, UserIndex, BinaryArray))
 				{
-					return JsonObject.ToSharedRef();
+					Payload = GameSerializerStorage::DecodeSaveFile(MoveTemp(BinaryArray));
 				}
 			}
 		}
 	}
+
+	if (Payload.IsValid())
+	{
+		if (Cache && bCacheHit == false)
+		{
+			Cache->Add({ FilePath, UserIndex }, Payload.ToSharedRef(), false);
+		}
+
+		const TArrayView<const uint8> PayloadView = Payload->GetView();
+		SavedContentHashes.Add({ FilePath, UserIndex }, CityHash64(reinterpret_cast<const char*>(PayloadView.GetData()), PayloadView.Num()));
+
+		// 动态对象在实例化时才解析，Payload由其持有
+		const TSharedPtr<FJsonObject> JsonObject = GameSerializerCore::DecodeJsonPayload(Payload.ToSharedRef());
+		if (ensure(JsonObject.IsValid()))
+		{
+			return JsonObject.ToSharedRef();
+		}
+	}
 	return {};
 }
 
+static bool WriteSaveFile(GameSerializerStorage::FSaveSlotContainer* Container, ISaveGameSystem* SaveSystem, int32 UserIndex, const FString& FilePath, TArrayView<const uint8> Payload, EGameSerializerSaveCodec Codec, int32 BlockSize)
+{
+	const TArray<uint8> FileData = GameSerializerStorage::EncodeSaveFile(Payload, Codec, BlockSize);
+	return Container ? Container->Write(FilePath, FileData, Codec) : SaveSystem->SaveGame(false, *FilePath, UserIndex, FileData);
+}
+
 void UGameSerializerManager::SaveJsonObject(UWorld* World, const TSharedRef<FJsonObject>& JsonObject, const FString& Category, const FString& FileName)
 {
+	const UGameSerializerSettings* Settings = GetDefault<UGameSerializerSettings>();
+	const TSharedPtr<GameSerializerStorage::FSaveSlotContainer> Container = GetSlotContainer();
 	ISaveGameSystem* SaveSystem = IPlatformFeaturesModule::Get().GetSaveGameSystem();
-	if (ensure(SaveSystem))
+	if (Container || ensure(SaveSystem))
 	{
-		const FString JsonString = GameSerializerCore::JsonObjectToString(JsonObject);
+		const TSharedRef<GameSerializerCore::FJsonPayload> Payload = MakeShared<GameSerializerCore::FJsonPayload>();
+		Payload->Data = GameSerializerCore::EncodeJsonPayload(JsonObject);
+		const FString FilePath = FPaths::Combine(Category, FileName);
 
-		const FTCHARToUTF8 UTF8String(*JsonString);
-		
-		TArray<uint8> BinaryBuffer;
-		const int32 UncompressedSize = UTF8String.Length();
-		int32 CompressionHeader = UncompressedSize;
-		const int32 CompressionHeaderSize = sizeof(CompressionHeader);
+		// 内容与上次读取或储存时一致则跳过压缩与写入
+		const uint64 ContentHash = CityHash64(reinterpret_cast<const char*>(Payload->Data.GetData()), Payload->Data.Num());
+		if (const uint64* SavedContentHash = SavedContentHashes.Find({ FilePath, UserIndex }))
+		{
+			if (*SavedContentHash == ContentHash)
+			{
+				UE_LOG(GameSerializer_Log, Verbose, TEXT("存档[%s]内容未变化，跳过写入"), *FilePath);
+				return;
+			}
+		}
 
-		int32 CompressedSize = FMath::TruncToInt(1.1f * UncompressedSize);
-		BinaryBuffer.SetNum(CompressionHeaderSize + CompressedSize);
+		// 映射读取的Payload仍可能引用原文件，改写前换成拷贝
+		if (Container == nullptr)
+		{
+			GameSerializerStorage::ReleaseMappedSaveFile(GameSerializerStorage::GetSaveGameFilePath(FilePath));
+		}
 
-		uint8* CompressedBuffer = BinaryBuffer.GetData();
-		FMemory::Memcpy(CompressedBuffer, &CompressionHeader, CompressionHeaderSize);
-		CompressedBuffer += CompressionHeaderSize;
+		if (const TSharedPtr<GameSerializerStorage::FPayloadCache> Cache = GetPayloadCache())
+		{
+			// 写入完成前重新加载直接读取缓存，写入失败时再清除哈希
+			Cache->Add({ FilePath, UserIndex }, Payload, true);
+			SavedContentHashes.Add({ FilePath, UserIndex }, ContentHash);
 
-		FCompression::CompressMemory(NAME_Zlib, CompressedBuffer, CompressedSize, UTF8String.Get(), UncompressedSize, COMPRESS_BiasMemory);
+			// 压缩在后台进行，存档容器自身加锁可以直接在后台写入
+			// 平台存档系统不保证可以在游戏线程之外调用，回到游戏线程后通过SaveGameAsync写入
+			if (Container == nullptr)
+			{
+				PendingSaveGameNum += 1;
+			}
+			auto WriteTask = [WeakThis = TWeakObjectPtr<UGameSerializerManager>(this), Container, SaveUserIndex = UserIndex, FilePath, Payload, ContentHash, Codec = Settings->SaveCodec, BlockSize = Settings->CompressionBlockSize]()
+			{
+				const TSharedRef<const TArray<uint8>> FileData = MakeShared<const TArray<uint8>>(GameSerializerStorage::EncodeSaveFile(Payload->Data, Codec, BlockSize));
+				const bool bSaved = Container && Container->Write(FilePath, *FileData, Codec);
+				AsyncTask(ENamedThreads::GameThread, [WeakThis, Container, SaveUserIndex, FilePath, Payload, ContentHash, FileData, bSaved]()
+				{
+					if (UGameSerializerManager* Manager = WeakThis.Get())
+					{
+						if (Container)
+						{
+							Manager->WhenPayloadWritten(SaveUserIndex, FilePath, ContentHash, Payload, bSaved);
+						}
+						else
+						{
+							Manager->WriteSaveGameAsync(SaveUserIndex, FilePath, FileData, Payload, ContentHash);
+						}
+					}
+				});
+			};
+			// 依次写入，同一存档后储存的内容后写入
+			PendingWriteTask = PendingWriteTask.IsValid()
+				? UE::Tasks::Launch(UE_SOURCE_LOCATION, MoveTemp(WriteTask), UE::Tasks::Prerequisites(PendingWriteTask))
+				: UE::Tasks::Launch(UE_SOURCE_LOCATION, MoveTemp(WriteTask));
+			return;
+		}
 
-		BinaryBuffer.SetNum(CompressionHeaderSize + CompressedSize);
-		
-		SaveSystem->SaveGame(false, *FPaths::Combine(Category, FileName), UserIndex, BinaryBuffer);
+		if (WriteSaveFile(Container.Get(), SaveSystem, UserIndex, FilePath, Payload->Data, Settings->SaveCodec, Settings->CompressionBlockSize))
+		{
+			SavedContentHashes.Add({ FilePath, UserIndex }, ContentHash);
+		}
+		else
+		{
+			SavedContentHashes.Remove({ FilePath, UserIndex });
+		}
+	}
+}
+
+void UGameSerializerManager::WhenPayloadWritten(int32 SaveUserIndex, const FString& FilePath, uint64 ContentHash, const TSharedRef<const GameSerializerCore::FJsonPayload>& Payload, bool bSaved)
+{
+	if (PayloadCache)
+	{
+		PayloadCache->MarkWritten({ FilePath, SaveUserIndex }, Payload);
+	}
+	if (bSaved == false)
+	{
+		UE_LOG(GameSerializer_Log, Error, TEXT("存档[%s]写入失败"), *FilePath);
+		const uint64* SavedContentHash = SavedContentHashes.Find({ FilePath, SaveUserIndex });
+		if (SavedContentHash && *SavedContentHash == ContentHash)
+		{
+			SavedContentHashes.Remove({ FilePath, SaveUserIndex });
+		}
+	}
+}
+
+void UGameSerializerManager::WriteSaveGameAsync(int32 SaveUserIndex, const FString& FilePath, const TSharedRef<const TArray<uint8>>& FileData, const TSharedRef<const GameSerializerCore::FJsonPayload>& Payload, uint64 ContentHash)
+{
+	FSaveGameWrite& SaveGameWrite = SaveGameWrites.FindOrAdd({ FilePath, SaveUserIndex });
+	if (SaveGameWrite.bInFlight)
+	{
+		// 同一存档依次写入，等待中的旧内容被新内容替换
+		if (SaveGameWrite.QueuedFileData.IsValid())
+		{
+			PendingSaveGameNum -= 1;
+		}
+		SaveGameWrite.QueuedFileData = FileData;
+		SaveGameWrite.QueuedPayload = Payload;
+		SaveGameWrite.QueuedContentHash = ContentHash;
+		return;
+	}
+
+	ISaveGameSystem* SaveSystem = IPlatformFeaturesModule::Get().GetSaveGameSystem();
+	if (ensure(SaveSystem) == false)
+	{
+		SaveGameWrite.bInFlight = true;
+		WhenSaveGameWritten(SaveUserIndex, FilePath, Payload, ContentHash, false);
+		return;
+	}
+	SaveGameWrite.bInFlight = true;
+	// 回调在游戏线程执行
+	SaveSystem->SaveGameAsync(false, *FilePath, FPlatformMisc::GetPlatformUserForUserIndex(SaveUserIndex), FileData,
+		[WeakThis = TWeakObjectPtr<UGameSerializerManager>(this), SaveUserIndex, Payload, ContentHash](const FString& SavedFilePath, FPlatformUserId PlatformUserId, bool bSaved)
+		{
+			if (UGameSerializerManager* Manager = WeakThis.Get())
+			{
+				Manager->WhenSaveGameWritten(SaveUserIndex, SavedFilePath, Payload, ContentHash, bSaved);
+			}
+		});
+}
+
+void UGameSerializerManager::WhenSaveGameWritten(int32 SaveUserIndex, const FString& FilePath, const TSharedRef<const GameSerializerCore::FJsonPayload>& Payload, uint64 ContentHash, bool bSaved)
+{
+	PendingSaveGameNum -= 1;
+	WhenPayloadWritten(SaveUserIndex, FilePath, ContentHash, Payload, bSaved);
+
+	const TPair<FString, int32> SaveKey{ FilePath, SaveUserIndex };
+	FSaveGameWrite* SaveGameWrite = SaveGameWrites.Find(SaveKey);
+	if (ensure(SaveGameWrite) == false)
+	{
+		return;
+	}
+	SaveGameWrite->bInFlight = false;
+	if (SaveGameWrite->QueuedFileData.IsValid())
+	{
+		const TSharedRef<const TArray<uint8>> FileData = SaveGameWrite->QueuedFileData.ToSharedRef();
+		const TSharedRef<const GameSerializerCore::FJsonPayload> QueuedPayload = SaveGameWrite->QueuedPayload.ToSharedRef();
+		const uint64 QueuedContentHash = SaveGameWrite->QueuedContentHash;
+		SaveGameWrite->QueuedFileData.Reset();
+		SaveGameWrite->QueuedPayload.Reset();
+		WriteSaveGameAsync(SaveUserIndex, FilePath, FileData, QueuedPayload, QueuedContentHash);
+	}
+	else
+	{
+		SaveGameWrites.Remove(SaveKey);
+	}
+}
+
+void UGameSerializerManager::FlushPendingWrites()
+{
+	if (PendingWriteTask.IsValid())
+	{
+		PendingWriteTask.Wait();
+		PendingWriteTask = UE::Tasks::FTask();
+	}
+
+	// 平台存档系统的写入在游戏线程发起与回调，等待期间处理游戏线程的任务
+	constexpr double FlushTimeoutSeconds = 30.0;
+	const double FlushStartTime = FPlatformTime::Seconds();
+	while (PendingSaveGameNum > 0)
+	{
+		FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+		if (PendingSaveGameNum == 0)
+		{
+			break;
+		}
+		if (FPlatformTime::Seconds() - FlushStartTime > FlushTimeoutSeconds)
+		{
+			UE_LOG(GameSerializer_Log, Error, TEXT("等待存档写入超时，剩余[%d]个存档"), PendingSaveGameNum);
+			break;
+		}
+		FPlatformProcess::Sleep(0.001f);
+	}
+}
+
+TSharedPtr<GameSerializerStorage::FSaveSlotContainer> UGameSerializerManager::GetSlotContainer()
+{
+	const UGameSerializerSettings* Settings = GetDefault<UGameSerializerSettings>();
+	if (Settings->bUseSlotContainer == false)
+	{
+		return nullptr;
+	}
+	if (SlotContainer.IsValid() == false && bSlotContainerOpenFailed == false)
+	{
+		const FString ContainerName = FString::Printf(TEXT("%s_%d"), *Settings->SlotContainerName, UserIndex);
+		SlotContainer = GameSerializerStorage::FSaveSlotContainer::Open(GameSerializerStorage::GetSaveGameFilePath(ContainerName), Settings->SlotCompactDeadRatio);
+		// 打开失败后不再重试，存档改为单独的文件储存
+		if (SlotContainer.IsValid() == false)
+		{
+			UE_LOG(GameSerializer_Log, Warning, TEXT("存档容器[%s]不可用，使用单独的存档文件"), *ContainerName);
+			bSlotContainerOpenFailed = true;
+		}
+		else if (SlotContainer->IsLegacyImported() == false)
+		{
+			SlotContainer->ImportLegacySaveFiles({ TEXT("Levels"), TEXT("Players") });
+		}
+	}
+	return SlotContainer;
+}
+
+TSharedPtr<GameSerializerStorage::FPayloadCache> UGameSerializerManager::GetPayloadCache()
+{
+	const UGameSerializerSettings* Settings = GetDefault<UGameSerializerSettings>();
+	if (Settings->PayloadCacheSizeMB <= 0)
+	{
+		return nullptr;
+	}
+	if (PayloadCache.IsValid() == false)
+	{
+		PayloadCache = MakeShared<GameSerializerStorage::FPayloadCache>();
+		PayloadCache->SetBudget(int64(Settings->PayloadCacheSizeMB) * 1024 * 1024);
+	}
+	return PayloadCache;
+}
+
+UGameSerializerManager::FScopedSkipInitSpawnActor::FScopedSkipInitSpawnActor(UGameSerializerManager& InManager, bool bInSkip)
+	: Manager(InManager)
+	, bSkip(bInSkip)
+{
+	if (bSkip)
+	{
+		Manager.SkipInitSpawnActorCounter += 1;
+	}
+}
+
+UGameSerializerManager::FScopedSkipInitSpawnActor::~FScopedSkipInitSpawnActor()
+{
+	if (bSkip)
+	{
+		check(Manager.SkipInitSpawnActorCounter > 0);
+		Manager.SkipInitSpawnActorCounter -= 1;
 	}
 }
 
 void UGameSerializerManager::InitActorAndComponents(AActor* Actor)
 {
-	check(Actor->Implements<UActorGameSerializerInterface>());
+	check(GameSerializerClassCache::Get(Actor->GetClass()).bActorInterface);
 	IActorGameSerializerInterface::WhenGameInit(Actor);
 }
 
@@ -298,12 +584,15 @@ struct FLevelDeserializer : public GameSerializerCore::FJsonToStruct
 		: Super(Level, RootJsonObject)
 	{
 		CheckFlags = CPF_SaveGame;
-		OldWorldOffset = GetStruct<FIntVector>(JsonFieldName::WorldOrigin);
+		WorldOffset = GetStruct<FIntVector>(JsonFieldName::WorldOrigin) - Level->GetWorld()->OriginLocation;
 	}
 
-	FIntVector OldWorldOffset;
+	// 等待加入世界期间保留的内存
+	SIZE_T RetainedSize = 0;
 };
 
+DECLARE_MEMORY_STAT(TEXT("GameSerializerManager_StreamLoadedLevelMemory"), STAT_GameSerializerManager_StreamLoadedLevelMemory, STATGROUP_GameSerializer);
+
 DECLARE_CYCLE_STAT(TEXT("GameSerializerManager_LoadLevel"), STAT_GameSerializerManage_LoadLevel, STATGROUP_GameSerializer);
 DECLARE_CYCLE_STAT(TEXT("GameSerializerManager_InitLevel"), STAT_GameSerializerManage_InitLevel, STATGROUP_GameSerializer);
 DECLARE_CYCLE_STAT(TEXT("GameSerializerManager_LoadStreamLevelEnd"), STAT_GameSerializerManager_LoadStreamLevelEnd, STATGROUP_GameSerializer);
@@ -317,6 +606,9 @@ void UGameSerializerManager::LoadOrInitLevel(ULevel* Level)
 	}
 	LoadedLevels.Add(Level);
 
+	// 流式关卡在加载完成时已经记录过
+	CaptureLevelBaselines(Level);
+
 	auto LoadLevelExtendData = [](const FLevelDeserializer& LevelDeserializer, const TSet<UObject*>& LoadedActors)
 	{
 		using FInstancedObjectData = FLevelDeserializer::FInstancedObjectData;
@@ -370,19 +662,23 @@ void UGameSerializerManager::LoadOrInitLevel(ULevel* Level)
 			{
 				return;
 			}
+			// 开启对象池时关卡在移除流程开始前已经储存
 			const bool IsLoadedLevel = LoadedLevels.Contains(RemovedLevel);
-			ensure(IsLoadedLevel);
+			ensure(IsLoadedLevel || UWorld::GetSubsystem<UGameSerializerActorPool>(World));
 			if (IsLoadedLevel == false)
 			{
 				return;
 			}
 			LoadedLevels.Remove(RemovedLevel);
 			SerializeLevel(RemovedLevel);
+			LevelBaselinesMap.Remove(RemovedLevel);
 		});
 	}
 
 	if (bInvokeLoadGame)
 	{
+		// 通常在关卡开始可见时已经完成，这里处理没有经过流式关卡状态变化加入的关卡
+		FinishPendingLevelLoad(Level);
 		if (TSharedRef<FLevelDeserializer>* StreamLoadedLevelDeserializerPtr = StreamLoadedLevelDataMap.Find(Level))
 		{
 			GameSerializerStatLog(STAT_GameSerializerManager_LoadStreamLevelEnd);
@@ -390,11 +686,14 @@ void UGameSerializerManager::LoadOrInitLevel(ULevel* Level)
 			UE_LOG(GameSerializer_Log, Display, TEXT("完成流式关卡[%s]加载"), *LevelName);
 
 			FLevelDeserializer& LevelDeserializer = StreamLoadedLevelDeserializerPtr->Get();
+			// 关卡加入世界时已分帧注册了自动注册的组件，剩余的在执行PostLoad前注册
+			LevelDeserializer.RegisterPendingComponents();
 			LevelDeserializer.RestoreDynamicActorSpawnedData();
 
 			const TSet<UObject*> LoadedActors{ LevelDeserializer.GetObjects(JsonFieldName::LevelActors) };
 			LoadLevelExtendData(LevelDeserializer, LoadedActors);
 
+			DEC_MEMORY_STAT_BY(STAT_GameSerializerManager_StreamLoadedLevelMemory, LevelDeserializer.RetainedSize);
 			StreamLoadedLevelDataMap.Remove(Level);
 			WhenLevelLoaded(Level);
 			return;
@@ -403,7 +702,7 @@ void UGameSerializerManager::LoadOrInitLevel(ULevel* Level)
 		TOptional<TSharedRef<FJsonObject>> JsonObject = TryLoadJsonObject(Level->GetWorld(), TEXT("Levels"), *LevelName);
 		if (JsonObject.IsSet())
 		{
-			FGuardValue_Bitfield(bShouldInitSpawnActor, false);
+			const FScopedSkipInitSpawnActor SkipInitSpawnActor(*this);
 
 			GameSerializerStatLog(STAT_GameSerializerManage_LoadLevel);
 			
@@ -412,19 +711,18 @@ void UGameSerializerManager::LoadOrInitLevel(ULevel* Level)
 			TArray<AActor*> PrepareLoadActors;
 			for (AActor* Actor : Level->Actors)
 			{
-				if (IsValid(Actor) && Actor->Implements<UActorGameSerializerInterface>() && IActorGameSerializerInterface::CanGameSerializedInLevel(Actor))
+				if (IsValid(Actor) && IActorGameSerializerInterface::IsGameSerializedInLevel(Actor) && UGameSerializerActorPool::IsParked(Actor) == false)
 				{
 					PrepareLoadActors.Add(Actor);
 				}
 			}
 
 			FLevelDeserializer LevelDeserializer(Level, JsonObject.GetValue());
-			const FIntVector OldWorldOrigin = LevelDeserializer.GetStruct<FIntVector>(JsonFieldName::WorldOrigin);
-			TGuardValue<FIntVector> WorldOffsetGuard(GameSerializerContext::WorldOffset, OldWorldOrigin - Level->GetWorld()->OriginLocation);
 
 			LevelDeserializer.LoadExternalObject();
 			LevelDeserializer.InstanceDynamicObject();
 			LevelDeserializer.LoadDynamicObjectJsonData();
+			LevelDeserializer.RegisterPendingComponents();
 			LevelDeserializer.DynamicActorFinishSpawning();
 			LevelDeserializer.RestoreDynamicActorSpawnedData();
 
@@ -458,7 +756,7 @@ void UGameSerializerManager::LoadOrInitLevel(ULevel* Level)
 		for (int32 Idx = 0; Idx < Level->Actors.Num(); ++Idx)
 		{
 			AActor* Actor = Level->Actors[Idx];
-			if (IsValid(Actor) && Actor->Implements<UActorGameSerializerInterface>() && IActorGameSerializerInterface::CanGameSerializedInLevel(Actor))
+			if (IsValid(Actor) && IActorGameSerializerInterface::IsGameSerializedInLevel(Actor) && UGameSerializerActorPool::IsParked(Actor) == false)
 			{
 				ActorsToLoad.Add({ Actor, IActorGameSerializerInterface::GetGameSerializePriority(Actor) });
 			}
@@ -473,7 +771,6 @@ void UGameSerializerManager::LoadOrInitLevel(ULevel* Level)
 	}
 }
 
-DECLARE_CYCLE_STAT(TEXT("GameSerializerManager_LoadStreamLevelStart"), STAT_GameSerializerManager_LoadStreamLevelStart, STATGROUP_GameSerializer);
 DECLARE_CYCLE_STAT(TEXT("GameSerializerManager_LoadOrInitWorld"), STAT_GameSerializerManage_LoadOrInitWorld, STATGROUP_GameSerializer);
 void UGameSerializerManager::LoadOrInitWorld(UWorld* World)
 {
@@ -490,9 +787,22 @@ void UGameSerializerManager::LoadOrInitWorld(UWorld* World)
 	ensure(LoadedLevels.Num() == 0);
 	LoadedLevels.Reset();
 	
+	for (const TPair<TWeakObjectPtr<ULevel>, TSharedRef<FLevelDeserializer>>& Pair : StreamLoadedLevelDataMap)
+	{
+		DEC_MEMORY_STAT_BY(STAT_GameSerializerManager_StreamLoadedLevelMemory, Pair.Value->RetainedSize);
+	}
 	StreamLoadedLevelDataMap.Reset();
-	CachedLevelStreamingLambdas.Reset();
-	UpdateLevelStreamingData();
+	ResetPendingLevelLoads();
+	LevelBaselinesMap.Reset();
+	ResetLevelStreamingLambdas();
+	if (bInvokeLoadGame)
+	{
+		// 之后新增的流式关卡在状态变化时注册
+		for (ULevelStreaming* LevelStreaming : World->GetStreamingLevels())
+		{
+			RegisterLevelStreaming(LevelStreaming);
+		}
+	}
 
 	for (ULevel* Level : World->GetLevels())
 	{
@@ -501,13 +811,39 @@ void UGameSerializerManager::LoadOrInitWorld(UWorld* World)
 
 	World->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateWeakLambda(this, [this](AActor* Actor)
 	{
-		if (bShouldInitSpawnActor && Actor->Implements<UActorGameSerializerInterface>() && IActorGameSerializerInterface::CanGameSerializedInLevel(Actor))
+		// 大量生成的非序列化Actor（投射物、特效）只需一次查表
+		if (SkipInitSpawnActorCounter == 0 && IActorGameSerializerInterface::IsGameSerializedInLevel(Actor) && UGameSerializerActorPool::IsParked(Actor) == false)
 		{
 			InitActorAndComponents(Actor);
 		}
 	}));
 }
 
+DECLARE_CYCLE_STAT(TEXT("GameSerializerManager_CaptureLevelBaselines"), STAT_GameSerializerManager_CaptureLevelBaselines, STATGROUP_GameSerializer);
+void UGameSerializerManager::CaptureLevelBaselines(ULevel* Level)
+{
+	if (LevelBaselinesMap.Contains(Level))
+	{
+		return;
+	}
+
+	GameSerializerStatLog(STAT_GameSerializerManager_CaptureLevelBaselines);
+
+	// 流式关卡在加入世界前记录，此时组件未注册，变换需要按关卡变换计算
+	const ULevelStreaming* LevelStreaming = Level->bIsVisible ? nullptr : ULevelStreaming::FindStreamingLevel(Level);
+	const FTransform* PendingLevelTransform = LevelStreaming ? &LevelStreaming->LevelTransform : nullptr;
+
+	const TSharedRef<GameSerializerCore::FObjectBaselines> LevelBaselines = MakeShared<GameSerializerCore::FObjectBaselines>(CPF_SaveGame);
+	for (AActor* Actor : Level->Actors)
+	{
+		if (IsValid(Actor) && IActorGameSerializerInterface::IsGameSerializedInLevel(Actor) && UGameSerializerActorPool::IsParked(Actor) == false)
+		{
+			LevelBaselines->CaptureActor(Actor, PendingLevelTransform);
+		}
+	}
+	LevelBaselinesMap.Add(Level, LevelBaselines);
+}
+
 void UGameSerializerManager::SerializeLevel(ULevel* Level)
 {
 	AWorldSettings* LevelSettings = CastChecked<UWorld>(Level->GetOuter())->GetWorldSettings();
@@ -528,18 +864,38 @@ void UGameSerializerManager::SerializeLevel(ULevel* Level)
 		AActor* Actor;
 		int32 Priority;
 	};
+	struct FLevelSerializer : public GameSerializerCore::FStructToJson
+	{
+		FLevelSerializer()
+		{
+			CheckFlags = CPF_SaveGame;
+		}
+	};
+	FLevelSerializer LevelSerializer;
+
+	// 预先建立关卡内Actor的归属关系，编码时无需再查询
 	TArray<FActorSortUnit> ToSaveActors;
 	for (AActor* Actor : Level->Actors)
 	{
-		if (IsValid(Actor) && Actor->Implements<UActorGameSerializerInterface>() && IActorGameSerializerInterface::CanGameSerializedInLevel(Actor))
+		if (IsValid(Actor) && GameSerializerClassCache::Get(Actor->GetClass()).bActorInterface && UGameSerializerActorPool::IsParked(Actor) == false)
 		{
-			if (ensure(IActorGameSerializerInterface::GetGameSerializedOwner(Actor) == nullptr))
+			AActor* SerializedOwner = IActorGameSerializerInterface::GetGameSerializedOwner(Actor);
+			LevelSerializer.PrecomputeSerializedOuter(Actor, SerializedOwner);
+			if (IActorGameSerializerInterface::CanGameSerializedInLevel(Actor) && ensure(SerializedOwner == nullptr))
 			{
 				ToSaveActors.Add({ Actor, IActorGameSerializerInterface::GetGameSerializePriority(Actor) });
 			}
 		}
 	}
-	ToSaveActors.Sort([](const FActorSortUnit& LHS, const FActorSortUnit& RHS){ return LHS.Priority > RHS.Priority; });
+	// 优先级相同时按名字排序，保证相同的关卡状态得到相同的存档内容
+	ToSaveActors.Sort([](const FActorSortUnit& LHS, const FActorSortUnit& RHS)
+	{
+		if (LHS.Priority != RHS.Priority)
+		{
+			return LHS.Priority > RHS.Priority;
+		}
+		return LHS.Actor->GetFName().Compare(RHS.Actor->GetFName()) < 0;
+	});
 
 	TArray<UObject*> SerializeList;
 	SerializeList.SetNum(ToSaveActors.Num());
@@ -547,16 +903,11 @@ void UGameSerializerManager::SerializeLevel(ULevel* Level)
 	{
 		SerializeList[Idx] = ToSaveActors[Idx].Actor;
 	}
-	
-	struct FLevelSerializer : public GameSerializerCore::FStructToJson
-	{
-		FLevelSerializer()
-		{
-			CheckFlags = CPF_SaveGame;
-		}
-	};
 
-	FLevelSerializer LevelSerializer;
+	if (const TSharedRef<GameSerializerCore::FObjectBaselines>* LevelBaselines = LevelBaselinesMap.Find(Level))
+	{
+		LevelSerializer.Baselines = &LevelBaselines->Get();
+	}
 	LevelSerializer.AddStruct(JsonFieldName::WorldOrigin, Level->GetWorld()->OriginLocation);
 	LevelSerializer.AddObjects(JsonFieldName::LevelActors, SerializeList);
 
@@ -569,6 +920,9 @@ void UGameSerializerManager::SerializeWorldWhenRemoved(UWorld* World)
 	check(LoadedWorld == World);
 	ArchiveWorldAllState(World);
 	LoadedLevels.Empty();
+	LevelBaselinesMap.Empty();
+	ResetLevelStreamingLambdas();
+	ResetPendingLevelLoads();
 	LoadedWorld = nullptr;
 }
 
@@ -576,6 +930,9 @@ void UGameSerializerManager::ArchiveWorldAllState(UWorld* World)
 {
 	if (ensure(IsArchiveWorld(World)))
 	{
+		// 整个世界的存档只写入一次容器目录
+		GameSerializerStorage::FSaveSlotContainer::FScopedBatch SlotContainerBatch(GetSlotContainer());
+
 		for (auto PlayerControllerIterator = World->GetPlayerControllerIterator(); PlayerControllerIterator; ++PlayerControllerIterator)
 		{
 			APlayerController* PlayerController = PlayerControllerIterator->Get();
@@ -592,6 +949,9 @@ void UGameSerializerManager::ArchiveWorldAllState(UWorld* World)
 			ULevel* Level = Levels[Idx];
 			SerializeLevel(Level);
 		}
+
+		// 后台写入在批量写入结束前完成，容器目录同样只写入一次
+		FlushPendingWrites();
 	}
 }
 
@@ -609,76 +969,280 @@ void UGameSerializerManager::OpenWorld(TSoftObjectPtr<UWorld> ToWorld)
 	}
 }
 
-void UGameSerializerManager::UpdateLevelStreamingData()
+void UGameSerializerManager::RegisterLevelStreaming(ULevelStreaming* LevelStreaming)
 {
-	if (bInvokeLoadGame == false)
+	if (LevelStreaming == nullptr || LevelStreamingLambdas.Contains(LevelStreaming))
 	{
 		return;
 	}
 
-	UWorld* World = LoadedWorld.Get();
-	if (World == nullptr)
+	UGameSerializerLevelStreamingLambda* LevelStreamingLambda = NewObject<UGameSerializerLevelStreamingLambda>(LevelStreaming);
+	LevelStreamingLambdas.Add(LevelStreaming, LevelStreamingLambda);
+	LevelStreaming->OnLevelLoaded.AddUniqueDynamic(LevelStreamingLambda, &UGameSerializerLevelStreamingLambda::WhenLevelLoaded);
+	LevelStreamingLambda->OnLevelLoaded.BindUObject(this, &UGameSerializerManager::WhenStreamingLevelLoaded);
+}
+
+void UGameSerializerManager::UnregisterLevelStreaming(ULevelStreaming* LevelStreaming)
+{
+	UGameSerializerLevelStreamingLambda* LevelStreamingLambda;
+	if (LevelStreamingLambdas.RemoveAndCopyValue(LevelStreaming, LevelStreamingLambda) && LevelStreamingLambda)
+	{
+		LevelStreaming->OnLevelLoaded.RemoveDynamic(LevelStreamingLambda, &UGameSerializerLevelStreamingLambda::WhenLevelLoaded);
+		LevelStreamingLambda->OnLevelLoaded.Unbind();
+	}
+}
+
+void UGameSerializerManager::ResetLevelStreamingLambdas()
+{
+	for (const TPair<ULevelStreaming*, UGameSerializerLevelStreamingLambda*>& Pair : LevelStreamingLambdas)
+	{
+		if (IsValid(Pair.Key) && Pair.Value)
+		{
+			Pair.Key->OnLevelLoaded.RemoveDynamic(Pair.Value, &UGameSerializerLevelStreamingLambda::WhenLevelLoaded);
+			Pair.Value->OnLevelLoaded.Unbind();
+		}
+	}
+	LevelStreamingLambdas.Reset();
+}
+
+// 流式关卡的读档分为解析、实例化、读取属性三个阶段，按优先级分帧执行
+struct FPendingLevelLoad
+{
+	enum class EPhase : uint8
+	{
+		Decode,
+		Instantiate,
+		Apply
+	};
+
+	TWeakObjectPtr<ULevel> Level;
+	TWeakObjectPtr<ULevelStreaming> LevelStreaming;
+	FString LevelName;
+	FBox Bounds;
+	// 阻塞游戏的关卡优先于距离
+	bool bBlockOnLoad = false;
+	EPhase Phase = EPhase::Decode;
+	double SortKey = 0.0;
+
+	TSharedPtr<FLevelDeserializer> LevelDeserializer;
+	TArray<TWeakObjectPtr<AActor>> PrepareLoadActors;
+
+	bool IsParsing() const { return Phase == EPhase::Instantiate && LevelDeserializer.IsValid() && LevelDeserializer->IsParsingDynamicObjects(); }
+};
+
+void UGameSerializerManager::WhenStreamingLevelLoaded(ULevel* LoadedLevel)
+{
+	// 注册时关卡已经载入的情况下会被直接调用，之后可能再收到OnLevelLoaded
+	if (LoadedLevel == nullptr || StreamLoadedLevelDataMap.Contains(LoadedLevel) || LoadedLevels.Contains(LoadedLevel)
+		|| PendingLevelLoads.ContainsByPredicate([&](const TSharedRef<FPendingLevelLoad>& E) { return E->Level == LoadedLevel; }))
 	{
 		return;
 	}
-	
-	const TArray<ULevelStreaming*>& StreamingLevels = World->GetStreamingLevels();
-	for (auto It = CachedLevelStreamingLambdas.CreateIterator(); It; ++It)
+
+	const TSharedRef<FPendingLevelLoad> LevelLoad = MakeShared<FPendingLevelLoad>();
+	LevelLoad->Level = LoadedLevel;
+	LevelLoad->LevelName = GetLevelPath(LoadedLevel);
+
+	const float LoadBudgetMs = GetDefault<UGameSerializerSettings>()->LevelLoadBudgetMs;
+	ULevelStreaming* LevelStreaming = ULevelStreaming::FindStreamingLevel(LoadedLevel);
+	if (LoadBudgetMs <= 0.f || LevelStreaming == nullptr)
 	{
-		const UGameSerializerLevelStreamingLambda* StreamingLambda = *It;
-		if (StreamingLevels.Contains(StreamingLambda->GetOuter()) == false)
+		while (StepLevelLoad(*LevelLoad) == false)
 		{
-			It.RemoveCurrent();
 		}
+		return;
 	}
-	for (ULevelStreaming* LevelStreaming : StreamingLevels)
+
+	// 关卡还未加入世界，组件没有注册，按根组件的相对位置计算包围盒后变换到关卡的位置
+	LevelLoad->LevelStreaming = LevelStreaming;
+	FBox Bounds(ForceInit);
+	for (const AActor* Actor : LoadedLevel->Actors)
 	{
-		if (CachedLevelStreamingLambdas.ContainsByPredicate([&](const UGameSerializerLevelStreamingLambda* E) { return E->GetOuter() == LevelStreaming; }) == false)
+		const USceneComponent* RootComponent = Actor ? Actor->GetRootComponent() : nullptr;
+		if (RootComponent && RootComponent->GetAttachParent() == nullptr)
 		{
-			UGameSerializerLevelStreamingLambda* LevelStreamingLambda = NewObject<UGameSerializerLevelStreamingLambda>(LevelStreaming);
-			CachedLevelStreamingLambdas.Add(LevelStreamingLambda);
-			LevelStreaming->OnLevelLoaded.AddDynamic(LevelStreamingLambda, &UGameSerializerLevelStreamingLambda::WhenLevelLoaded);
-			LevelStreamingLambda->OnLevelLoaded.BindWeakLambda(this, [this](ULevel* LoadedLevel)
+			Bounds += RootComponent->GetRelativeLocation();
+		}
+	}
+	LevelLoad->Bounds = Bounds.TransformBy(LevelStreaming->LevelTransform);
+	LevelLoad->bBlockOnLoad = LevelStreaming->bShouldBlockOnLoad;
+	PendingLevelLoads.Add(LevelLoad);
+
+	if (LevelLoadTickerHandle.IsValid() == false)
+	{
+		LevelLoadTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UGameSerializerManager::TickLevelLoads));
+	}
+}
+
+DECLARE_CYCLE_STAT(TEXT("GameSerializerManager_LoadStreamLevelDecode"), STAT_GameSerializerManager_LoadStreamLevelDecode, STATGROUP_GameSerializer);
+DECLARE_CYCLE_STAT(TEXT("GameSerializerManager_LoadStreamLevelInstantiate"), STAT_GameSerializerManager_LoadStreamLevelInstantiate, STATGROUP_GameSerializer);
+DECLARE_CYCLE_STAT(TEXT("GameSerializerManager_LoadStreamLevelApply"), STAT_GameSerializerManager_LoadStreamLevelApply, STATGROUP_GameSerializer);
+bool UGameSerializerManager::StepLevelLoad(FPendingLevelLoad& LevelLoad)
+{
+	ULevel* LoadedLevel = LevelLoad.Level.Get();
+	// 等待期间被卸载的关卡不再读档
+	if (LoadedLevel == nullptr || (LevelLoad.LevelStreaming.IsValid() && LevelLoad.LevelStreaming->GetLoadedLevel() != LoadedLevel))
+	{
+		return true;
+	}
+
+	switch (LevelLoad.Phase)
+	{
+	case FPendingLevelLoad::EPhase::Decode:
+	{
+		CaptureLevelBaselines(LoadedLevel);
+
+		TOptional<TSharedRef<FJsonObject>> JsonObject = TryLoadJsonObject(LoadedLevel->GetWorld(), TEXT("Levels"), *LevelLoad.LevelName);
+		if (JsonObject.IsSet() == false)
+		{
+			return true;
+		}
+
+		GameSerializerStatLog(STAT_GameSerializerManager_LoadStreamLevelDecode);
+
+		UE_LOG(GameSerializer_Log, Display, TEXT("加载流式关卡[%s]"), *LevelLoad.LevelName);
+
+		LevelLoad.LevelDeserializer = MakeShared<FLevelDeserializer>(LoadedLevel, JsonObject.GetValue());
+		LevelLoad.LevelDeserializer->LoadExternalObject();
+		// 解析在后台进行，其他关卡的阶段可以同时执行，实例化阶段等待解析完成
+		LevelLoad.LevelDeserializer->StartParseDynamicObjects();
+		LevelLoad.Phase = FPendingLevelLoad::EPhase::Instantiate;
+		return false;
+	}
+	case FPendingLevelLoad::EPhase::Instantiate:
+	{
+		const FScopedSkipInitSpawnActor SkipInitSpawnActor(*this);
+
+		GameSerializerStatLog(STAT_GameSerializerManager_LoadStreamLevelInstantiate);
+
+		for (AActor* Actor : LoadedLevel->Actors)
+		{
+			if (IsValid(Actor) && IActorGameSerializerInterface::IsGameSerializedInLevel(Actor) && UGameSerializerActorPool::IsParked(Actor) == false)
 			{
-				const FString LevelName = GetLevelPath(LoadedLevel);
-				TOptional<TSharedRef<FJsonObject>> JsonObject = TryLoadJsonObject(LoadedLevel->GetWorld(), TEXT("Levels"), *LevelName);
-				if (JsonObject.IsSet())
-				{
-					FGuardValue_Bitfield(bShouldInitSpawnActor, false);
+				LevelLoad.PrepareLoadActors.Add(Actor);
+			}
+		}
+
+		LevelLoad.LevelDeserializer->InstanceDynamicObject();
+		LevelLoad.Phase = FPendingLevelLoad::EPhase::Apply;
+		return false;
+	}
+	case FPendingLevelLoad::EPhase::Apply:
+	{
+		const FScopedSkipInitSpawnActor SkipInitSpawnActor(*this);
 
-					GameSerializerStatLog(STAT_GameSerializerManager_LoadStreamLevelStart);
+		GameSerializerStatLog(STAT_GameSerializerManager_LoadStreamLevelApply);
 
-					UE_LOG(GameSerializer_Log, Display, TEXT("加载流式关卡[%s]"), *LevelName);
+		const TSharedRef<FLevelDeserializer> LevelDeserializer = LevelLoad.LevelDeserializer.ToSharedRef();
+		LevelDeserializer->LoadDynamicObjectJsonData();
 
-					TArray<AActor*> PrepareLoadActors;
-					for (AActor* Actor : LoadedLevel->Actors)
-					{
-						if (IsValid(Actor) && Actor->Implements<UActorGameSerializerInterface>() && IActorGameSerializerInterface::CanGameSerializedInLevel(Actor))
-						{
-							PrepareLoadActors.Add(Actor);
-						}
-					}
+		const TArray<UObject*> LoadedActors = LevelDeserializer->GetObjects(JsonFieldName::LevelActors);
+		for (const TWeakObjectPtr<AActor>& PrepareLoadActor : LevelLoad.PrepareLoadActors)
+		{
+			AActor* Actor = PrepareLoadActor.Get();
+			if (IsValid(Actor) && LoadedActors.Contains(Actor) == false)
+			{
+				Actor->Destroy();
+			}
+		}
 
-					const TSharedRef<FLevelDeserializer> LevelDeserializer = MakeShared<FLevelDeserializer>(LoadedLevel, JsonObject.GetValue());
-					const FIntVector OldWorldOrigin = LevelDeserializer->GetStruct<FIntVector>(JsonFieldName::WorldOrigin);
-					TGuardValue<FIntVector> WorldOffsetGuard(GameSerializerContext::WorldOffset, OldWorldOrigin - LoadedLevel->GetWorld()->OriginLocation);
-					LevelDeserializer->LoadExternalObject();
-					LevelDeserializer->InstanceDynamicObject();
-					LevelDeserializer->LoadDynamicObjectJsonData();
+		// 加入世界前只需要扩展数据与RepNotify
+		LevelDeserializer->CompactForPostLoad();
+		LevelDeserializer->RetainedSize = LevelDeserializer->GetAllocatedSize();
+		INC_MEMORY_STAT_BY(STAT_GameSerializerManager_StreamLoadedLevelMemory, LevelDeserializer->RetainedSize);
+		UE_LOG(GameSerializer_Log, Verbose, TEXT("流式关卡[%s]等待加入世界，保留读档数据[%.1f KB]"), *LevelLoad.LevelName, LevelDeserializer->RetainedSize / 1024.0);
 
-					const TArray<UObject*> LoadedActors = LevelDeserializer->GetObjects(JsonFieldName::LevelActors);
-					for (AActor* Actor : PrepareLoadActors)
-					{
-						if (IsValid(Actor) && LoadedActors.Contains(Actor) == false)
-						{
-							Actor->Destroy();
-						}
-					}
-					StreamLoadedLevelDataMap.Add(LoadedLevel, LevelDeserializer);
-				}
-			});
+		StreamLoadedLevelDataMap.Add(LoadedLevel, LevelDeserializer);
+		return true;
+	}
+	}
+	return true;
+}
+
+void UGameSerializerManager::FinishPendingLevelLoad(ULevel* Level)
+{
+	const int32 Idx = PendingLevelLoads.IndexOfByPredicate([&](const TSharedRef<FPendingLevelLoad>& E) { return E->Level == Level; });
+	if (Idx != INDEX_NONE)
+	{
+		// 关卡即将加入世界，剩余的阶段不再等待
+		const TSharedRef<FPendingLevelLoad> LevelLoad = PendingLevelLoads[Idx];
+		PendingLevelLoads.RemoveAt(Idx);
+		while (StepLevelLoad(*LevelLoad) == false)
+		{
+		}
+	}
+}
+
+void UGameSerializerManager::ResetPendingLevelLoads()
+{
+	PendingLevelLoads.Empty();
+	if (LevelLoadTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(LevelLoadTickerHandle);
+		LevelLoadTickerHandle.Reset();
+	}
+}
+
+DECLARE_CYCLE_STAT(TEXT("GameSerializerManager_TickLevelLoads"), STAT_GameSerializerManager_TickLevelLoads, STATGROUP_GameSerializer);
+bool UGameSerializerManager::TickLevelLoads(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GameSerializerManager_TickLevelLoads);
+
+	UWorld* World = LoadedWorld.Get();
+	if (World == nullptr || PendingLevelLoads.Num() == 0)
+	{
+		PendingLevelLoads.Empty();
+		LevelLoadTickerHandle.Reset();
+		return false;
+	}
+
+	// 离玩家视点越近越优先，阻塞游戏的关卡最优先
+	TArray<FVector, TInlineAllocator<4>> ViewLocations;
+	for (auto PlayerControllerIterator = World->GetPlayerControllerIterator(); PlayerControllerIterator; ++PlayerControllerIterator)
+	{
+		if (const APlayerController* PlayerController = PlayerControllerIterator->Get())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			ViewLocations.Add(ViewLocation);
+		}
+	}
+	for (const TSharedRef<FPendingLevelLoad>& LevelLoad : PendingLevelLoads)
+	{
+		double MinDistSquared = ViewLocations.Num() > 0 ? TNumericLimits<double>::Max() : 0.0;
+		for (const FVector& ViewLocation : ViewLocations)
+		{
+			MinDistSquared = FMath::Min<double>(MinDistSquared, LevelLoad->Bounds.IsValid ? LevelLoad->Bounds.ComputeSquaredDistanceToPoint(ViewLocation) : 0.0);
+		}
+		LevelLoad->SortKey = LevelLoad->bBlockOnLoad ? -1.0 : MinDistSquared;
+	}
+	PendingLevelLoads.StableSort([](const TSharedRef<FPendingLevelLoad>& LHS, const TSharedRef<FPendingLevelLoad>& RHS) { return LHS->SortKey < RHS->SortKey; });
+
+	// 每帧至少执行一个阶段
+	const double EndTime = FPlatformTime::Seconds() + GetDefault<UGameSerializerSettings>()->LevelLoadBudgetMs / 1000.0;
+	do
+	{
+		// 后台解析中的关卡先让出，推进后续关卡，都在解析时等待优先级最高的关卡
+		int32 LevelLoadIdx = PendingLevelLoads.IndexOfByPredicate([](const TSharedRef<FPendingLevelLoad>& E) { return E->IsParsing() == false; });
+		if (LevelLoadIdx == INDEX_NONE)
+		{
+			LevelLoadIdx = 0;
+		}
+		const TSharedRef<FPendingLevelLoad> LevelLoad = PendingLevelLoads[LevelLoadIdx];
+		if (StepLevelLoad(*LevelLoad))
+		{
+			PendingLevelLoads.RemoveAt(LevelLoadIdx);
 		}
 	}
+	while (PendingLevelLoads.Num() > 0 && FPlatformTime::Seconds() < EndTime);
+
+	if (PendingLevelLoads.Num() == 0)
+	{
+		LevelLoadTickerHandle.Reset();
+		return false;
+	}
+	return true;
 }
 
 FString UGameSerializerManager::GetLevelPath(const ULevel* Level)
@@ -738,7 +1302,8 @@ APawn* UGameSerializerManager::LoadOrSpawnDefaultPawn(AGameModeBase* GameMode, A
 	UE_LOG(GameSerializer_Log, Display, TEXT("玩家[%s]启动游戏序列化系统"), *PlayerName);
 
 	TOptional<TSharedRef<FJsonObject>> JsonObject = bInvokeLoadGame ? TryLoadJsonObject(World, TEXT("Players"), *PlayerName) : TOptional<TSharedRef<FJsonObject>>();
-	FGuardValue_Bitfield(bShouldInitSpawnActor, bInvokeLoadGame ? JsonObject.IsSet() == false : true);
+	// 读档的玩家不需要初始化
+	const FScopedSkipInitSpawnActor SkipInitSpawnActor(*this, JsonObject.IsSet());
 	FActorSpawnParameters SpawnInfo;
 	SpawnInfo.bNoFail = true;
 	SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
@@ -775,21 +1340,20 @@ APawn* UGameSerializerManager::LoadOrSpawnDefaultPawn(AGameModeBase* GameMode, A
 		PlayerDeserializer.RetargetDynamicObjectName(JsonFieldName::PlayerState, PlayerState->GetFName());
 		PlayerDeserializer.RetargetDynamicObjectName(JsonFieldName::PlayerPawn, Pawn->GetFName());
 		
-		const FIntVector OldWorldOrigin = PlayerDeserializer.GetStruct<FIntVector>(JsonFieldName::WorldOrigin);
-		TGuardValue<FIntVector> WorldOffsetGuard(GameSerializerContext::WorldOffset, OldWorldOrigin - Pawn->GetWorld()->OriginLocation);
+		PlayerDeserializer.WorldOffset = PlayerDeserializer.GetStruct<FIntVector>(JsonFieldName::WorldOrigin) - World->OriginLocation;
 		PlayerDeserializer.LoadAllDataImmediately();
 	}
 	else
 	{
-		if (PlayerController->Implements<UActorGameSerializerInterface>())
+		if (GameSerializerClassCache::Get(PlayerController->GetClass()).bActorInterface)
 		{
 			IActorGameSerializerInterface::WhenGameInit(PlayerController);
 		}
-		if (PlayerState->Implements<UActorGameSerializerInterface>())
+		if (GameSerializerClassCache::Get(PlayerState->GetClass()).bActorInterface)
 		{
 			IActorGameSerializerInterface::WhenGameInit(PlayerState);
 		}
-		if (Pawn->Implements<UActorGameSerializerInterface>())
+		if (GameSerializerClassCache::Get(Pawn->GetClass()).bActorInterface)
 		{
 			IActorGameSerializerInterface::WhenGameInit(Pawn);
 		}
@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameSerializerSettings.h"
+
+#include "GameSerializer_Log.h"
+
+UGameSerializerSettings::UGameSerializerSettings()
+{
+	CategoryName = TEXT("Plugins");
+	SectionName = TEXT("GameSerializer");
+}
+
+bool UGameSerializerSettings::IsBinarySerializeStruct(const UScriptStruct* Struct) const
+{
+	if (BinarySerializeStructs.Num() == 0)
+	{
+		return false;
+	}
+	if (bBinarySerializeStructSetDirty)
+	{
+		check(IsInGameThread());
+		bBinarySerializeStructSetDirty = false;
+		BinarySerializeStructSet.Reset();
+		for (const TSoftObjectPtr<UScriptStruct>& BinarySerializeStruct : BinarySerializeStructs)
+		{
+			if (const UScriptStruct* LoadedStruct = BinarySerializeStruct.LoadSynchronous())
+			{
+				// NetSerialize是网络协议格式，依赖PackageMap与复制标签表，不能用于存档
+				const UScriptStruct::ICppStructOps* CppStructOps = LoadedStruct->GetCppStructOps();
+				if (CppStructOps == nullptr || CppStructOps->HasSerializer() == false)
+				{
+					UE_LOG(GameSerializer_Log, Warning, TEXT("结构体[%s]没有原生的Serialize，不能储存为二进制数据"), *LoadedStruct->GetName());
+					continue;
+				}
+				BinarySerializeStructSet.Add(LoadedStruct);
+			}
+		}
+	}
+	return BinarySerializeStructSet.Contains(Struct);
+}
+
+void UGameSerializerSettings::PostReloadConfig(FProperty* PropertyThatWasLoaded)
+{
+	Super::PostReloadConfig(PropertyThatWasLoaded);
+	bBinarySerializeStructSetDirty = true;
+}
+
+#if WITH_EDITOR
+void UGameSerializerSettings::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	bBinarySerializeStructSetDirty = true;
+	if (PropertyChangedEvent.GetMemberPropertyName() == GET_MEMBER_NAME_CHECKED(UGameSerializerSettings, BinarySerializeStructs))
+	{
+		// 编辑时立即检查，不支持的结构体给出警告
+		IsBinarySerializeStruct(nullptr);
+	}
+}
+#endif
@@ -0,0 +1,873 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameSerializerStorage.h"
+#include <Async/MappedFileHandle.h>
+#include <HAL/FileManager.h>
+#include <HAL/PlatformFileManager.h>
+#include <Misc/Compression.h>
+#include <Misc/FileHelper.h>
+#include <Misc/Paths.h>
+#include <Hash/CityHash.h>
+#include <Serialization/MemoryReader.h>
+#include <Serialization/MemoryWriter.h>
+
+#include "GameSerializerSettings.h"
+#include "GameSerializer_Log.h"
+
+namespace GameSerializerStorage
+{
+	using GameSerializerCore::FJsonPayload;
+
+	// 旧存档为 [int32 解压后大小][Zlib数据]，新存档以文件头开始
+	// BlockZlib在文件头后记录每块压缩后的大小 int32[NumBlocks]，之后为各块数据
+	constexpr uint32 SaveFileMagic = 0x46535347; // "GSSF"
+
+	struct FSaveFileHeader
+	{
+		uint32 Magic;
+		uint8 Codec;
+		uint8 Padding[3];
+		int32 UncompressedSize;
+		int32 BlockSize;
+		int32 NumBlocks;
+	};
+	static_assert(sizeof(FSaveFileHeader) == 20, "存档文件头大小变化会导致旧存档无法读取");
+	constexpr int32 SaveFileHeaderSize = sizeof(FSaveFileHeader);
+
+	// 存档文件的原始数据，来自SaveGameSystem读取的数组或映射的文件
+	// 未压缩时即作为Payload使用
+	struct FSaveFilePayload : FJsonPayload
+	{
+		TUniquePtr<IMappedFileHandle> MappedFileHandle;
+		TUniquePtr<IMappedFileRegion> MappedFileRegion;
+		TArrayView<const uint8> FileView;
+		TArrayView<const uint8> PayloadView;
+
+		TArrayView<const uint8> GetView() const override { return PayloadView; }
+
+		// 复制Payload后关闭映射，文件之后可以被改写
+		void ReleaseMapping()
+		{
+			FWriteScopeLock Lock(ViewLock);
+			if (MappedFileRegion.IsValid())
+			{
+				Data = TArray<uint8>(PayloadView.GetData(), PayloadView.Num());
+				PayloadView = Data;
+				FileView = TArrayView<const uint8>();
+				MappedFileRegion.Reset();
+				MappedFileHandle.Reset();
+			}
+		}
+	};
+
+	// 直接引用映射内存的Payload，改写同名存档前需要关闭映射
+	static FCriticalSection MappedSaveFilesCriticalSection;
+	static TMap<FString, TArray<TWeakPtr<FSaveFilePayload>>> MappedSaveFiles;
+
+	TArray<uint8> EncodeSaveFile(TArrayView<const uint8> Payload, EGameSerializerSaveCodec Codec, int32 BlockSize)
+	{
+		FSaveFileHeader Header;
+		FMemory::Memzero(Header);
+		Header.Magic = SaveFileMagic;
+		Header.Codec = uint8(Codec);
+		Header.UncompressedSize = Payload.Num();
+
+		TArray<uint8> FileData;
+		switch (Codec)
+		{
+		case EGameSerializerSaveCodec::None:
+		{
+			FileData.Reserve(SaveFileHeaderSize + Payload.Num());
+			FileData.Append(reinterpret_cast<const uint8*>(&Header), SaveFileHeaderSize);
+			FileData.Append(Payload.GetData(), Payload.Num());
+			break;
+		}
+		case EGameSerializerSaveCodec::BlockZlib:
+		{
+			check(BlockSize > 0);
+			Header.BlockSize = BlockSize;
+			Header.NumBlocks = FMath::DivideAndRoundUp(Payload.Num(), BlockSize);
+			const int32 BlockTableSize = Header.NumBlocks * int32(sizeof(int32));
+
+			FileData.Append(reinterpret_cast<const uint8*>(&Header), SaveFileHeaderSize);
+			FileData.AddZeroed(BlockTableSize);
+			for (int32 BlockIdx = 0; BlockIdx < Header.NumBlocks; ++BlockIdx)
+			{
+				const int32 UncompressedBlockSize = FMath::Min(BlockSize, Payload.Num() - BlockIdx * BlockSize);
+				int32 CompressedBlockSize = FCompression::CompressMemoryBound(NAME_Zlib, UncompressedBlockSize);
+				const int32 BlockOffset = FileData.Num();
+				FileData.AddUninitialized(CompressedBlockSize);
+				FCompression::CompressMemory(NAME_Zlib, FileData.GetData() + BlockOffset, CompressedBlockSize, Payload.GetData() + BlockIdx * BlockSize, UncompressedBlockSize, COMPRESS_BiasMemory);
+				FileData.SetNum(BlockOffset + CompressedBlockSize);
+				FMemory::Memcpy(FileData.GetData() + SaveFileHeaderSize + BlockIdx * sizeof(int32), &CompressedBlockSize, sizeof(int32));
+			}
+			break;
+		}
+		default:
+		{
+			int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, Payload.Num());
+			FileData.SetNumUninitialized(SaveFileHeaderSize + CompressedSize);
+			FMemory::Memcpy(FileData.GetData(), &Header, SaveFileHeaderSize);
+			FCompression::CompressMemory(NAME_Zlib, FileData.GetData() + SaveFileHeaderSize, CompressedSize, Payload.GetData(), Payload.Num(), COMPRESS_BiasMemory);
+			FileData.SetNum(SaveFileHeaderSize + CompressedSize);
+			break;
+		}
+		}
+		return FileData;
+	}
+
+	static TSharedPtr<FJsonPayload> DecodeSaveFile(const TSharedRef<FSaveFilePayload>& SaveFile)
+	{
+		const TArrayView<const uint8> FileView = SaveFile->FileView;
+		uint32 Magic = 0;
+		if (FileView.Num() >= int32(sizeof(Magic)))
+		{
+			FMemory::Memcpy(&Magic, FileView.GetData(), sizeof(Magic));
+		}
+
+		if (Magic != SaveFileMagic || FileView.Num() < SaveFileHeaderSize)
+		{
+			int32 UncompressedSize = 0;
+			const int32 CompressionHeaderSize = sizeof(UncompressedSize);
+			if (FileView.Num() < CompressionHeaderSize)
+			{
+				return nullptr;
+			}
+			FMemory::Memcpy(&UncompressedSize, FileView.GetData(), CompressionHeaderSize);
+			if (ensure(UncompressedSize >= 0) == false)
+			{
+				return nullptr;
+			}
+
+			const TSharedRef<FJsonPayload> Payload = MakeShared<FJsonPayload>();
+			Payload->Data.SetNumUninitialized(UncompressedSize);
+			if (FCompression::UncompressMemory(NAME_Zlib, Payload->Data.GetData(), UncompressedSize, FileView.GetData() + CompressionHeaderSize, FileView.Num() - CompressionHeaderSize) == false)
+			{
+				return nullptr;
+			}
+			return Payload;
+		}
+
+		FSaveFileHeader Header;
+		FMemory::Memcpy(&Header, FileView.GetData(), SaveFileHeaderSize);
+		if (ensure(Header.UncompressedSize >= 0) == false)
+		{
+			return nullptr;
+		}
+		const TArrayView<const uint8> BodyView = FileView.Slice(SaveFileHeaderSize, FileView.Num() - SaveFileHeaderSize);
+		switch (EGameSerializerSaveCodec(Header.Codec))
+		{
+		case EGameSerializerSaveCodec::None:
+		{
+			if (ensure(Header.UncompressedSize <= BodyView.Num()) == false)
+			{
+				return nullptr;
+			}
+			SaveFile->PayloadView = BodyView.Slice(0, Header.UncompressedSize);
+			return SaveFile;
+		}
+		case EGameSerializerSaveCodec::BlockZlib:
+		{
+			const int64 BlockTableSize = int64(Header.NumBlocks) * sizeof(int32);
+			if (ensure(Header.BlockSize > 0 && Header.NumBlocks >= 0 && BlockTableSize <= BodyView.Num()) == false)
+			{
+				return nullptr;
+			}
+
+			const TSharedRef<FJsonPayload> Payload = MakeShared<FJsonPayload>();
+			Payload->Data.SetNumUninitialized(Header.UncompressedSize);
+			int32 BlockOffset = int32(BlockTableSize);
+			for (int32 BlockIdx = 0; BlockIdx < Header.NumBlocks; ++BlockIdx)
+			{
+				int32 CompressedBlockSize;
+				FMemory::Memcpy(&CompressedBlockSize, BodyView.GetData() + BlockIdx * sizeof(int32), sizeof(int32));
+				const int32 UncompressedBlockSize = FMath::Min(Header.BlockSize, Header.UncompressedSize - BlockIdx * Header.BlockSize);
+				if (ensure(CompressedBlockSize >= 0 && BlockOffset + CompressedBlockSize <= BodyView.Num() && UncompressedBlockSize > 0) == false)
+				{
+					return nullptr;
+				}
+				if (FCompression::UncompressMemory(NAME_Zlib, Payload->Data.GetData() + BlockIdx * Header.BlockSize, UncompressedBlockSize, BodyView.GetData() + BlockOffset, CompressedBlockSize) == false)
+				{
+					return nullptr;
+				}
+				BlockOffset += CompressedBlockSize;
+			}
+			return Payload;
+		}
+		case EGameSerializerSaveCodec::Zlib:
+		{
+			const TSharedRef<FJsonPayload> Payload = MakeShared<FJsonPayload>();
+			Payload->Data.SetNumUninitialized(Header.UncompressedSize);
+			if (FCompression::UncompressMemory(NAME_Zlib, Payload->Data.GetData(), Header.UncompressedSize, BodyView.GetData(), BodyView.Num()) == false)
+			{
+				return nullptr;
+			}
+			return Payload;
+		}
+		default:
+			UE_LOG(GameSerializer_Log, Error, TEXT("未知的存档压缩方式[%d]"), Header.Codec);
+			return nullptr;
+		}
+	}
+
+	TSharedPtr<FJsonPayload> DecodeSaveFile(TArray<uint8>&& FileData)
+	{
+		const TSharedRef<FSaveFilePayload> SaveFile = MakeShared<FSaveFilePayload>();
+		SaveFile->Data = MoveTemp(FileData);
+		SaveFile->FileView = SaveFile->Data;
+		return DecodeSaveFile(SaveFile);
+	}
+
+	TSharedPtr<FJsonPayload> DecodeMappedSaveFile(const FString& FilePath)
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		TUniquePtr<IMappedFileHandle> MappedFileHandle(PlatformFile.OpenMapped(*FilePath));
+		if (MappedFileHandle == nullptr)
+		{
+			return nullptr;
+		}
+		const int64 FileSize = MappedFileHandle->GetFileSize();
+		if (FileSize <= 0 || ensure(FileSize <= MAX_int32) == false)
+		{
+			return nullptr;
+		}
+		TUniquePtr<IMappedFileRegion> MappedFileRegion(MappedFileHandle->MapRegion(0, FileSize));
+		if (MappedFileRegion == nullptr)
+		{
+			return nullptr;
+		}
+
+		const TSharedRef<FSaveFilePayload> SaveFile = MakeShared<FSaveFilePayload>();
+		SaveFile->FileView = MakeArrayView(MappedFileRegion->GetMappedPtr(), int32(MappedFileRegion->GetMappedSize()));
+		SaveFile->MappedFileHandle = MoveTemp(MappedFileHandle);
+		SaveFile->MappedFileRegion = MoveTemp(MappedFileRegion);
+		const TSharedPtr<FJsonPayload> Payload = DecodeSaveFile(SaveFile);
+		// 解压后的Payload不再引用映射，映射随SaveFile释放
+		if (Payload.Get() == &SaveFile.Get())
+		{
+			FScopeLock Lock(&MappedSaveFilesCriticalSection);
+			TArray<TWeakPtr<FSaveFilePayload>>& SaveFiles = MappedSaveFiles.FindOrAdd(FPaths::ConvertRelativePathToFull(FilePath));
+			SaveFiles.RemoveAll([](const TWeakPtr<FSaveFilePayload>& Element) { return Element.IsValid() == false; });
+			SaveFiles.Add(SaveFile);
+		}
+		return Payload;
+	}
+
+	void ReleaseMappedSaveFile(const FString& FilePath)
+	{
+		TArray<TWeakPtr<FSaveFilePayload>> SaveFiles;
+		{
+			FScopeLock Lock(&MappedSaveFilesCriticalSection);
+			MappedSaveFiles.RemoveAndCopyValue(FPaths::ConvertRelativePathToFull(FilePath), SaveFiles);
+		}
+		for (const TWeakPtr<FSaveFilePayload>& WeakSaveFile : SaveFiles)
+		{
+			if (const TSharedPtr<FSaveFilePayload> SaveFile = WeakSaveFile.Pin())
+			{
+				SaveFile->ReleaseMapping();
+			}
+		}
+	}
+
+	FString GetSaveGameFilePath(const FString& Name)
+	{
+		return FString::Printf(TEXT("%sSaveGames/%s.sav"), *FPaths::ProjectSavedDir(), *Name);
+	}
+
+	DECLARE_MEMORY_STAT(TEXT("PayloadCache_Memory"), STAT_GameSerializerPayloadCache_Memory, STATGROUP_GameSerializer);
+	DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("PayloadCache_Entries"), STAT_GameSerializerPayloadCache_Entries, STATGROUP_GameSerializer);
+	DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("PayloadCache_Hit"), STAT_GameSerializerPayloadCache_Hit, STATGROUP_GameSerializer);
+	DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("PayloadCache_Miss"), STAT_GameSerializerPayloadCache_Miss, STATGROUP_GameSerializer);
+
+	void FPayloadCache::SetBudget(int64 InBudgetBytes)
+	{
+		BudgetBytes = InBudgetBytes;
+		Evict();
+	}
+
+	TSharedPtr<const FJsonPayload> FPayloadCache::Find(const FKey& Key)
+	{
+		check(IsInGameThread());
+		if (FEntry* Entry = Entries.Find(Key))
+		{
+			Entry->LastUsed = ++UseCounter;
+			HitNum += 1;
+			INC_DWORD_STAT(STAT_GameSerializerPayloadCache_Hit);
+			return Entry->Payload;
+		}
+		MissNum += 1;
+		INC_DWORD_STAT(STAT_GameSerializerPayloadCache_Miss);
+		return nullptr;
+	}
+
+	void FPayloadCache::Add(const FKey& Key, const TSharedRef<const FJsonPayload>& Payload, bool bPendingWrite)
+	{
+		check(IsInGameThread());
+		Remove(Key);
+
+		const int64 Size = Payload->GetView().Num();
+		// 超出预算的Payload只在等待写入期间保留
+		if (bPendingWrite == false && Size > BudgetBytes)
+		{
+			return;
+		}
+		Entries.Add(Key, FEntry{ Payload, Size, ++UseCounter, bPendingWrite });
+		MemoryBytes += Size;
+		Evict();
+		UpdateMemoryStat();
+	}
+
+	void FPayloadCache::MarkWritten(const FKey& Key, const TSharedRef<const FJsonPayload>& Payload)
+	{
+		check(IsInGameThread());
+		FEntry* Entry = Entries.Find(Key);
+		if (Entry && Entry->Payload == Payload)
+		{
+			Entry->bPendingWrite = false;
+			Evict();
+			UpdateMemoryStat();
+		}
+	}
+
+	void FPayloadCache::Empty()
+	{
+		Entries.Empty();
+		MemoryBytes = 0;
+		UpdateMemoryStat();
+	}
+
+	void FPayloadCache::Remove(const FKey& Key)
+	{
+		if (const FEntry* Entry = Entries.Find(Key))
+		{
+			MemoryBytes -= Entry->Size;
+			Entries.Remove(Key);
+		}
+	}
+
+	void FPayloadCache::Evict()
+	{
+		// 关卡数量有限，直接遍历查找最久未使用的条目
+		while (MemoryBytes > BudgetBytes)
+		{
+			const FKey* OldestKey = nullptr;
+			uint64 OldestUsed = MAX_uint64;
+			for (const TPair<FKey, FEntry>& Pair : Entries)
+			{
+				if (Pair.Value.bPendingWrite == false && Pair.Value.LastUsed < OldestUsed)
+				{
+					OldestKey = &Pair.Key;
+					OldestUsed = Pair.Value.LastUsed;
+				}
+			}
+			if (OldestKey == nullptr)
+			{
+				break;
+			}
+			Remove(FKey(*OldestKey));
+		}
+	}
+
+	void FPayloadCache::UpdateMemoryStat() const
+	{
+		SET_MEMORY_STAT(STAT_GameSerializerPayloadCache_Memory, MemoryBytes);
+		SET_DWORD_STAT(STAT_GameSerializerPayloadCache_Entries, Entries.Num());
+	}
+
+	constexpr uint32 SlotContainerMagic = 0x43535347; // "GSSC"
+	// 1: 文件头增加代数，容器在两个文件间交替重写
+	constexpr uint32 SlotContainerVersion = 1;
+
+	struct FSlotContainerHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		int64 TocOffset;
+		int64 TocSize;
+		// 版本0没有该字段，视为0
+		uint64 Generation;
+	};
+	static_assert(sizeof(FSlotContainerHeader) == 32, "存档容器文件头大小变化会导致旧存档无法读取");
+	constexpr int64 SlotContainerHeaderSize = sizeof(FSlotContainerHeader);
+	constexpr int64 SlotContainerHeaderSizeV0 = 24;
+	// 废弃数据过少时整理的收益不足以抵消重写的开销
+	constexpr int64 MinCompactDeadBytes = 1024 * 1024;
+	// 目录中的空条目，表示启用容器前的单独存档文件已经导入
+	static const FString LegacyImportedMarkerName = TEXT("__LegacyImported");
+
+	static uint64 HashFileData(TArrayView<const uint8> FileData)
+	{
+		return CityHash64(reinterpret_cast<const char*>(FileData.GetData()), FileData.Num());
+	}
+
+	static bool ReadSlotContainerHeader(IFileHandle& Handle, FSlotContainerHeader& OutHeader, int64& OutHeaderSize)
+	{
+		FMemory::Memzero(OutHeader);
+		if (Handle.Size() < SlotContainerHeaderSizeV0 || Handle.Seek(0) == false || Handle.Read(reinterpret_cast<uint8*>(&OutHeader), SlotContainerHeaderSizeV0) == false)
+		{
+			return false;
+		}
+		if (OutHeader.Magic != SlotContainerMagic || OutHeader.Version > SlotContainerVersion)
+		{
+			return false;
+		}
+		if (OutHeader.Version == 0)
+		{
+			OutHeaderSize = SlotContainerHeaderSizeV0;
+			return true;
+		}
+		OutHeaderSize = SlotContainerHeaderSize;
+		return Handle.Read(reinterpret_cast<uint8*>(&OutHeader.Generation), sizeof(OutHeader.Generation));
+	}
+
+	static EGameSerializerSaveCodec GetSaveFileCodec(TArrayView<const uint8> FileData)
+	{
+		FSaveFileHeader Header;
+		if (FileData.Num() >= SaveFileHeaderSize)
+		{
+			FMemory::Memcpy(&Header, FileData.GetData(), SaveFileHeaderSize);
+			if (Header.Magic == SaveFileMagic)
+			{
+				return EGameSerializerSaveCodec(Header.Codec);
+			}
+		}
+		// 旧存档整体为Zlib压缩
+		return EGameSerializerSaveCodec::Zlib;
+	}
+
+	TSharedPtr<FSaveSlotContainer> FSaveSlotContainer::Open(const FString& FilePath, float CompactDeadRatio)
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		PlatformFile.CreateDirectoryTree(*FPaths::GetPath(FilePath));
+
+		const TSharedRef<FSaveSlotContainer> Container = MakeShared<FSaveSlotContainer>(FilePath, CompactDeadRatio);
+		if (Container->LoadLatest() == false)
+		{
+			UE_LOG(GameSerializer_Log, Error, TEXT("存档容器[%s]已损坏"), *FilePath);
+			return nullptr;
+		}
+		return Container;
+	}
+
+	FSaveSlotContainer::FSaveSlotContainer(const FString& InFilePath, float InCompactDeadRatio)
+		: FilePath(InFilePath)
+		, CompactDeadRatio(InCompactDeadRatio)
+	{}
+
+	FSaveSlotContainer::~FSaveSlotContainer()
+	{
+		ensure(BatchDepth == 0);
+		if (bWritable && bTocDirty)
+		{
+			WriteToc();
+		}
+	}
+
+	TSharedPtr<FJsonPayload> FSaveSlotContainer::Read(const FString& Name)
+	{
+		FScopeLock Lock(&CriticalSection);
+		const FEntry* Entry = Toc.Find(Name);
+		if (Entry == nullptr || FileHandle == nullptr)
+		{
+			return nullptr;
+		}
+
+		TArray<uint8> FileData;
+		FileData.SetNumUninitialized(Entry->Size);
+		if (FileHandle->Seek(Entry->Offset) == false || FileHandle->Read(FileData.GetData(), Entry->Size) == false)
+		{
+			UE_LOG(GameSerializer_Log, Error, TEXT("读取存档容器[%s]的条目[%s]失败"), *FilePath, *Name);
+			return nullptr;
+		}
+		if (ensureMsgf(HashFileData(FileData) == Entry->Hash, TEXT("存档容器[%s]的条目[%s]校验失败"), *FilePath, *Name) == false)
+		{
+			return nullptr;
+		}
+		return DecodeSaveFile(MoveTemp(FileData));
+	}
+
+	bool FSaveSlotContainer::Write(const FString& Name, TArrayView<const uint8> FileData, EGameSerializerSaveCodec Codec)
+	{
+		FScopeLock Lock(&CriticalSection);
+		if (BeginWrite() == false)
+		{
+			return false;
+		}
+
+		// 追加在当前目录之后，文件头改写前旧的目录依然有效
+		FEntry Entry;
+		Entry.Offset = FileSize;
+		Entry.Size = FileData.Num();
+		Entry.Codec = uint8(Codec);
+		Entry.Hash = HashFileData(FileData);
+		if (FileHandle->Seek(Entry.Offset) == false || FileHandle->Write(FileData.GetData(), FileData.Num()) == false)
+		{
+			UE_LOG(GameSerializer_Log, Error, TEXT("写入存档容器[%s]的条目[%s]失败"), *FilePath, *Name);
+			return false;
+		}
+		FileSize += Entry.Size;
+
+		if (const FEntry* OldEntry = Toc.Find(Name))
+		{
+			LiveBytes -= OldEntry->Size;
+		}
+		LiveBytes += Entry.Size;
+		Toc.Add(Name, Entry);
+		bTocDirty = true;
+
+		if (BatchDepth == 0)
+		{
+			Commit();
+		}
+		return true;
+	}
+
+	FSaveSlotContainer::FScopedBatch::FScopedBatch(const TSharedPtr<FSaveSlotContainer>& InContainer)
+		: Container(InContainer)
+	{
+		if (Container)
+		{
+			FScopeLock Lock(&Container->CriticalSection);
+			Container->BatchDepth += 1;
+		}
+	}
+
+	FSaveSlotContainer::FScopedBatch::~FScopedBatch()
+	{
+		if (Container)
+		{
+			FScopeLock Lock(&Container->CriticalSection);
+			Container->BatchDepth -= 1;
+			if (Container->BatchDepth == 0)
+			{
+				Container->Commit();
+			}
+		}
+	}
+
+	void FSaveSlotContainer::Commit()
+	{
+		FScopeLock Lock(&CriticalSection);
+		if (bTocDirty == false || WriteToc() == false)
+		{
+			return;
+		}
+
+		const int64 DeadBytes = GetDeadBytes();
+		if (DeadBytes > MinCompactDeadBytes && DeadBytes > FileSize * CompactDeadRatio)
+		{
+			Compact();
+		}
+	}
+
+	DECLARE_CYCLE_STAT(TEXT("GameSerializerStorage_Compact"), STAT_GameSerializerStorage_Compact, STATGROUP_GameSerializer);
+	void FSaveSlotContainer::Compact()
+	{
+		FScopeLock Lock(&CriticalSection);
+		if (bWritable == false || BatchDepth > 0)
+		{
+			return;
+		}
+
+		GameSerializerStatLog(STAT_GameSerializerStorage_Compact);
+		Rewrite(1 - ActiveFileIdx);
+	}
+
+	int64 FSaveSlotContainer::GetDeadBytes() const
+	{
+		FScopeLock Lock(&CriticalSection);
+		return FileSize - HeaderSize - TocSize - LiveBytes;
+	}
+
+	bool FSaveSlotContainer::IsLegacyImported() const
+	{
+		FScopeLock Lock(&CriticalSection);
+		return Toc.Contains(LegacyImportedMarkerName);
+	}
+
+	DECLARE_CYCLE_STAT(TEXT("GameSerializerStorage_ImportLegacySaveFiles"), STAT_GameSerializerStorage_ImportLegacySaveFiles, STATGROUP_GameSerializer);
+	void FSaveSlotContainer::ImportLegacySaveFiles(const TArray<FString>& Categories)
+	{
+		FScopeLock Lock(&CriticalSection);
+		if (Toc.Contains(LegacyImportedMarkerName))
+		{
+			return;
+		}
+
+		GameSerializerStatLog(STAT_GameSerializerStorage_ImportLegacySaveFiles);
+
+		// 与GetSaveGameFilePath的目录一致
+		const FString SaveGameDir = FPaths::ProjectSavedDir() / TEXT("SaveGames");
+		int32 ImportedNum = 0;
+		bool bSucceed = true;
+		BatchDepth += 1;
+		for (const FString& Category : Categories)
+		{
+			TArray<FString> Files;
+			IFileManager::Get().FindFilesRecursive(Files, *(SaveGameDir / Category), TEXT("*.sav"), true, false);
+			for (const FString& File : Files)
+			{
+				FString Name = File;
+				FPaths::MakePathRelativeTo(Name, *(SaveGameDir + TEXT("/")));
+				Name = Name.LeftChop(4);
+				// 容器中已有的存档比单独的文件新
+				if (Toc.Contains(Name))
+				{
+					continue;
+				}
+
+				TArray<uint8> FileData;
+				if (FFileHelper::LoadFileToArray(FileData, *File) && Write(Name, FileData, GetSaveFileCodec(FileData)))
+				{
+					ImportedNum += 1;
+				}
+				else
+				{
+					UE_LOG(GameSerializer_Log, Warning, TEXT("存档[%s]导入存档容器[%s]失败"), *File, *FilePath);
+					bSucceed = false;
+				}
+			}
+		}
+		// 有导入失败的存档时不写入标记，之后依然会查找单独的文件，下次打开时重试
+		if (bSucceed)
+		{
+			Write(LegacyImportedMarkerName, TArrayView<const uint8>(), EGameSerializerSaveCodec::None);
+		}
+		BatchDepth -= 1;
+		Commit();
+
+		UE_LOG(GameSerializer_Log, Display, TEXT("导入[%d]个单独的存档文件到存档容器[%s]"), ImportedNum, *FilePath);
+	}
+
+	FString FSaveSlotContainer::GetFilePath(int32 FileIdx) const
+	{
+		return FileIdx == 0 ? FilePath : FilePath + TEXT(".alt");
+	}
+
+	bool FSaveSlotContainer::LoadLatest()
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+		// 两个文件中代数较大的为最新，读取失败时退回另一个
+		TArray<TPair<int32, uint64>, TInlineAllocator<2>> Candidates;
+		bool bAnyFileExists = false;
+		for (int32 FileIdx = 0; FileIdx < 2; ++FileIdx)
+		{
+			const FString CandidatePath = GetFilePath(FileIdx);
+			if (PlatformFile.FileExists(*CandidatePath) == false)
+			{
+				continue;
+			}
+			bAnyFileExists = true;
+
+			const TUniquePtr<IFileHandle> Handle(PlatformFile.OpenRead(*CandidatePath));
+			FSlotContainerHeader Header;
+			int64 CandidateHeaderSize;
+			if (Handle && ReadSlotContainerHeader(*Handle, Header, CandidateHeaderSize))
+			{
+				Candidates.Emplace(FileIdx, Header.Generation);
+			}
+		}
+		// 新的容器在第一次写入时创建文件
+		if (bAnyFileExists == false)
+		{
+			return true;
+		}
+
+		Candidates.Sort([](const TPair<int32, uint64>& LHS, const TPair<int32, uint64>& RHS) { return LHS.Value > RHS.Value; });
+		for (const TPair<int32, uint64>& Candidate : Candidates)
+		{
+			FileHandle.Reset(PlatformFile.OpenRead(*GetFilePath(Candidate.Key)));
+			if (FileHandle && LoadToc())
+			{
+				ActiveFileIdx = Candidate.Key;
+				return true;
+			}
+			UE_LOG(GameSerializer_Log, Warning, TEXT("存档容器文件[%s]已损坏"), *GetFilePath(Candidate.Key));
+		}
+		FileHandle.Reset();
+		return false;
+	}
+
+	bool FSaveSlotContainer::BeginWrite()
+	{
+		if (bWritable)
+		{
+			return true;
+		}
+		// IPlatformFile无法以读写模式打开已有文件而不清空内容，第一次写入前把有效条目重写到另一个文件，之后在新文件中读写
+		return Rewrite(FileHandle ? 1 - ActiveFileIdx : ActiveFileIdx);
+	}
+
+	bool FSaveSlotContainer::Rewrite(int32 TargetFileIdx)
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		const FString TargetFilePath = GetFilePath(TargetFileIdx);
+		// 不追加，可以Seek后改写文件头
+		TUniquePtr<IFileHandle> TargetFileHandle(PlatformFile.OpenWrite(*TargetFilePath, false, true));
+		if (TargetFileHandle == nullptr)
+		{
+			UE_LOG(GameSerializer_Log, Error, TEXT("无法创建存档容器文件[%s]"), *TargetFilePath);
+			return false;
+		}
+
+		// 按原偏移的顺序复制，重写后的文件与写入顺序一致
+		TArray<TPair<FString, FEntry>*> Entries;
+		Entries.Reserve(Toc.Num());
+		for (TPair<FString, FEntry>& Pair : Toc)
+		{
+			Entries.Add(&Pair);
+		}
+		Entries.Sort([](const TPair<FString, FEntry>& LHS, const TPair<FString, FEntry>& RHS) { return LHS.Value.Offset < RHS.Value.Offset; });
+
+		TMap<FString, FEntry> NewToc;
+		NewToc.Reserve(Toc.Num());
+		int64 NewFileSize = SlotContainerHeaderSize;
+		TArray<uint8> FileData;
+		bool bSucceed = true;
+		for (const TPair<FString, FEntry>* Pair : Entries)
+		{
+			const FEntry& Entry = Pair->Value;
+			FileData.SetNumUninitialized(Entry.Size, false);
+			bSucceed = FileHandle->Seek(Entry.Offset) && FileHandle->Read(FileData.GetData(), Entry.Size)
+				&& TargetFileHandle->Seek(NewFileSize) && TargetFileHandle->Write(FileData.GetData(), Entry.Size);
+			if (bSucceed == false)
+			{
+				break;
+			}
+
+			FEntry& NewEntry = NewToc.Add(Pair->Key, Entry);
+			NewEntry.Offset = NewFileSize;
+			NewFileSize += Entry.Size;
+		}
+
+		// 目录与文件头完整写入后新文件的代数才大于原文件，任一步骤中断时原文件依然是最新的
+		int64 NewTocSize = 0;
+		bSucceed = bSucceed && WriteToc(*TargetFileHandle, NewToc, NewFileSize, Generation + 1, NewTocSize);
+		if (bSucceed == false)
+		{
+			UE_LOG(GameSerializer_Log, Error, TEXT("重写存档容器[%s]失败"), *FilePath);
+			TargetFileHandle.Reset();
+			PlatformFile.DeleteFile(*TargetFilePath);
+			return false;
+		}
+
+		FileHandle = MoveTemp(TargetFileHandle);
+		ActiveFileIdx = TargetFileIdx;
+		Generation += 1;
+		Toc = MoveTemp(NewToc);
+		HeaderSize = SlotContainerHeaderSize;
+		FileSize = NewFileSize + NewTocSize;
+		TocSize = NewTocSize;
+		bTocDirty = false;
+		bWritable = true;
+		return true;
+	}
+
+	bool FSaveSlotContainer::LoadToc()
+	{
+		const int64 PhysicalFileSize = FileHandle->Size();
+		FSlotContainerHeader Header;
+		int64 FileHeaderSize;
+		if (ReadSlotContainerHeader(*FileHandle, Header, FileHeaderSize) == false)
+		{
+			return false;
+		}
+		if (Header.TocOffset < FileHeaderSize || Header.TocSize < 0 || Header.TocSize > MAX_int32 || Header.TocOffset + Header.TocSize > PhysicalFileSize)
+		{
+			return false;
+		}
+
+		TArray<uint8> TocData;
+		TocData.SetNumUninitialized(Header.TocSize);
+		if (FileHandle->Seek(Header.TocOffset) == false || FileHandle->Read(TocData.GetData(), Header.TocSize) == false)
+		{
+			return false;
+		}
+
+		FMemoryReader Reader(TocData);
+		int32 Num = 0;
+		Reader << Num;
+		if (Reader.IsError() || Num < 0)
+		{
+			return false;
+		}
+		Toc.Empty(Num);
+		LiveBytes = 0;
+		for (int32 Idx = 0; Idx < Num; ++Idx)
+		{
+			FString Name;
+			FEntry Entry;
+			Reader << Name;
+			Reader << Entry.Offset;
+			Reader << Entry.Size;
+			Reader << Entry.Codec;
+			Reader << Entry.Hash;
+			if (Reader.IsError() || Entry.Offset < FileHeaderSize || Entry.Size < 0 || Entry.Size > MAX_int32 || Entry.Offset + Entry.Size > Header.TocOffset)
+			{
+				return false;
+			}
+			LiveBytes += Entry.Size;
+			Toc.Add(MoveTemp(Name), Entry);
+		}
+
+		// 目录之后的数据来自被中断的写入，重写时丢弃
+		Generation = Header.Generation;
+		HeaderSize = FileHeaderSize;
+		TocSize = Header.TocSize;
+		FileSize = Header.TocOffset + Header.TocSize;
+		bTocDirty = false;
+		return true;
+	}
+
+	bool FSaveSlotContainer::WriteToc()
+	{
+		check(bWritable);
+		int64 NewTocSize;
+		if (WriteToc(*FileHandle, Toc, FileSize, Generation, NewTocSize) == false)
+		{
+			UE_LOG(GameSerializer_Log, Error, TEXT("写入存档容器[%s]的目录失败"), *FilePath);
+			return false;
+		}
+
+		FileSize += NewTocSize;
+		TocSize = NewTocSize;
+		bTocDirty = false;
+		return true;
+	}
+
+	bool FSaveSlotContainer::WriteToc(IFileHandle& Handle, const TMap<FString, FEntry>& InToc, int64 TocOffset, uint64 InGeneration, int64& OutTocSize)
+	{
+		TArray<uint8> TocData;
+		FMemoryWriter Writer(TocData);
+		int32 Num = InToc.Num();
+		Writer << Num;
+		for (const TPair<FString, FEntry>& Pair : InToc)
+		{
+			FString Name = Pair.Key;
+			FEntry Entry = Pair.Value;
+			Writer << Name;
+			Writer << Entry.Offset;
+			Writer << Entry.Size;
+			Writer << Entry.Codec;
+			Writer << Entry.Hash;
+		}
+
+		FSlotContainerHeader Header;
+		Header.Magic = SlotContainerMagic;
+		Header.Version = SlotContainerVersion;
+		Header.TocOffset = TocOffset;
+		Header.TocSize = TocData.Num();
+		Header.Generation = InGeneration;
+
+		// 先写入目录再改写文件头，任一步骤中断时文件头依然指向旧的目录
+		if (Handle.Seek(Header.TocOffset) == false || Handle.Write(TocData.GetData(), TocData.Num()) == false || Handle.Flush(true) == false
+			|| Handle.Seek(0) == false || Handle.Write(reinterpret_cast<const uint8*>(&Header), SlotContainerHeaderSize) == false || Handle.Flush(true) == false)
+		{
+			return false;
+		}
+		OutTocSize = TocData.Num();
+		return true;
+	}
+}
@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameSerializerTraits.h"
+
+namespace GameSerializerNativeStruct
+{
+	TMap<const UScriptStruct*, FGameSerializerNativeStruct> NativeStructs;
+
+	void Register(const UScriptStruct* Struct, const FGameSerializerNativeStruct& NativeStruct)
+	{
+		check(IsInGameThread());
+		NativeStructs.Add(Struct, NativeStruct);
+	}
+
+	void Unregister(const UScriptStruct* Struct)
+	{
+		check(IsInGameThread());
+		NativeStructs.Remove(Struct);
+	}
+
+	const FGameSerializerNativeStruct* Find(const UScriptStruct* Struct)
+	{
+		// 大部分项目不会注册，跳过哈希
+		if (NativeStructs.Num() == 0)
+		{
+			return nullptr;
+		}
+		return NativeStructs.Find(Struct);
+	}
+}
@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameSerializerActorPool.generated.h"
+
+/**
+ * 流式关卡卸载时回收关卡内动态生成的Actor，读档时按类型复用，代替Spawn与Destroy
+ * 需要在UGameSerializerSettings中开启并配置可以回收的类型，复制的Actor不会被回收
+ * 回收时解除挂接并销毁运行时添加的组件与子对象，复用时非Transient的属性恢复为原型的值
+ * 非SaveGame的对象引用（如运行时替换的网格体、材质）不会被恢复，回收的类型需要保证这些状态可以沿用
+ */
+UCLASS()
+class GAMESERIALIZER_API UGameSerializerActorPool : public UWorldSubsystem
+{
+	GENERATED_BODY()
+public:
+	bool ShouldCreateSubsystem(UObject* Outer) const override;
+	bool DoesSupportWorldType(EWorldType::Type WorldType) const override;
+	void Deinitialize() override;
+
+	// 关卡储存后、移除流程开始前调用，回收的Actor移入持久关卡并停用
+	void ParkLevelActors(ULevel* Level);
+
+	// 取出同类型的Actor移入Level并重命名，属性重置为原型的值，没有可复用的Actor时返回空
+	AActor* Reuse(UClass* Class, ULevel* Level, const FName& Name, const FTransform& Transform);
+
+	int32 GetPooledNum() const;
+
+	// 回收中的Actor位于持久关卡但不属于任何关卡的存档，遍历关卡Actor时需要跳过
+	static bool IsParked(const AActor* Actor);
+private:
+	bool CanPool(const AActor* Actor) const;
+
+	TMap<TWeakObjectPtr<UClass>, TArray<TWeakObjectPtr<AActor>>> PooledActors;
+	TSet<TWeakObjectPtr<UClass>> PooledClasses;
+	TSet<TWeakObjectPtr<const AActor>> ParkedActors;
+};
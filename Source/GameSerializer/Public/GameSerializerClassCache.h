@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IGameSerializerInterface;
+class IActorGameSerializerInterface;
+
+/**
+ * 类型对序列化接口的实现情况，每个类型只计算一次
+ */
+struct FGameSerializerClassCapabilities
+{
+	TWeakObjectPtr<const UClass> Class;
+
+	uint8 bGameSerializerInterface : 1;
+	uint8 bActorInterface : 1;
+	uint8 bComponentInterface : 1;
+
+	// 接口事件没有被蓝图覆写且由C++实现时直接调用_Implementation，不经过蓝图的函数调用
+	uint8 bNativeCanGameSerializedInLevel : 1;
+	uint8 bNativeGetGameSerializedOwner : 1;
+	uint8 bNativeGetGameSerializePriority : 1;
+
+	// C++实现接口时接口相对对象的偏移，蓝图实现时为INDEX_NONE
+	int32 GameSerializerInterfaceOffset = INDEX_NONE;
+	int32 ActorInterfaceOffset = INDEX_NONE;
+
+	FGameSerializerClassCapabilities()
+		: bGameSerializerInterface(false)
+		, bActorInterface(false)
+		, bComponentInterface(false)
+		, bNativeCanGameSerializedInLevel(false)
+		, bNativeGetGameSerializedOwner(false)
+		, bNativeGetGameSerializePriority(false)
+	{}
+
+	const IGameSerializerInterface* GetNativeInterface(const UObject* Object) const
+	{
+		check(GameSerializerInterfaceOffset != INDEX_NONE);
+		return reinterpret_cast<const IGameSerializerInterface*>(reinterpret_cast<const uint8*>(Object) + GameSerializerInterfaceOffset);
+	}
+	const IActorGameSerializerInterface* GetNativeActorInterface(const UObject* Object) const
+	{
+		check(ActorInterfaceOffset != INDEX_NONE);
+		return reinterpret_cast<const IActorGameSerializerInterface*>(reinterpret_cast<const uint8*>(Object) + ActorInterfaceOffset);
+	}
+};
+
+namespace GameSerializerClassCache
+{
+	// 返回的引用在下一次查询前有效
+	GAMESERIALIZER_API const FGameSerializerClassCapabilities& Get(const UClass* Class);
+
+	// 类型被重新实例化（蓝图编译、热重载）后需要清空
+	GAMESERIALIZER_API void Flush();
+
+	DECLARE_MULTICAST_DELEGATE(FOnFlushed);
+	GAMESERIALIZER_API FOnFlushed& OnFlushed();
+
+	void Startup();
+	// 清空缓存并通知OnFlushed，之后解除所有OnFlushed的绑定
+	void Shutdown();
+}
@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+class UBlueprintGeneratedClass;
+
+/**
+ * 读档Spawn的蓝图Actor需要在反序列化属性前构造SCS组件
+ * 每个蓝图类型预先生成实例化计划（模板数据、挂接的父节点、赋值的属性），之后Spawn的同类型Actor直接按计划创建组件
+ */
+namespace GameSerializerComponentInstancing
+{
+	// 参见 USimpleConstructionScript::ExecuteScriptOnActor，取消了组件注册的流程
+	void InstanceComponents(UBlueprintGeneratedClass* Class, AActor* Actor, const FTransform& RootTransform);
+
+	// 类型被重新实例化后需要重新生成
+	void Flush();
+}
@@ -4,18 +4,15 @@
 
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
+#include "UObject/GCObject.h"
 #include <Dom/JsonValue.h>
+#include <Tasks/Task.h>
+#include "GameSerializerTraits.h"
 // #include "GameSerializerCore.generated.h"
 
-/**
- * 
- */
-namespace GameSerializerContext
-{
-	extern FIntVector WorldOffset;
-}
-
 struct FGameSerializerNetNotifyData;
+struct FGameSerializerExtendData;
+class AActor;
 
 namespace GameSerializerCore
 {
@@ -23,11 +20,76 @@ namespace GameSerializerCore
 
 	constexpr EPropertyFlags DefaultCheckFlags = CPF_AllFlags;
 	constexpr EPropertyFlags DefaultSkipFlags = CPF_None;
+
+	// 预放置对象在关卡载入时的状态，储存时作为比较的基准代替CDO
+	// 读档时预放置对象通过名字找回，未记录的属性保持关卡中的值
+	class GAMESERIALIZER_API FObjectBaselines : public FGCObject
+	{
+	public:
+		FObjectBaselines(EPropertyFlags CheckFlags);
+		~FObjectBaselines();
+		FObjectBaselines(const FObjectBaselines&) = delete;
+		FObjectBaselines& operator=(const FObjectBaselines&) = delete;
+
+		// ActorTransform为空时使用Actor当前的变换
+		void Capture(UObject* Object, const FTransform* ActorTransform = nullptr);
+		// 记录Actor与其组件
+		// 流式关卡加入世界前组件未注册且未应用关卡变换，通过PendingLevelTransform按根组件的相对变换计算加入世界后的变换
+		void CaptureActor(AActor* Actor, const FTransform* PendingLevelTransform = nullptr);
+
+		const void* Find(const UObject* Object) const;
+		const FTransform* FindActorTransform(const AActor* Actor) const;
+		int32 Num() const { return Baselines.Num(); }
+
+		void AddReferencedObjects(FReferenceCollector& Collector) override;
+		FString GetReferencerName() const override;
+	private:
+		struct FBaseline
+		{
+			TObjectPtr<UClass> Class = nullptr;
+			// 按类型完整构造，只复制了CheckFlags匹配的属性
+			uint8* Data = nullptr;
+			TOptional<FTransform> ActorTransform;
+		};
+		EPropertyFlags CheckFlags;
+		TMap<TWeakObjectPtr<const UObject>, FBaseline> Baselines;
+
+		static void Release(FBaseline& Baseline);
+	};
 	
+	// 以对象在GUObjectArray中的下标为键的分页平铺表，查找只需数组寻址
+	// 同时记录对象的序列号，下标被其他对象复用时视为不存在
+	class GAMESERIALIZER_API FObjectIndexTable
+	{
+	public:
+		FObjectIdx* Find(const UObject* Object);
+		FObjectIdx& FindOrAdd(const UObject* Object);
+		void Add(const UObject* Object, FObjectIdx ObjectIdx) { FindOrAdd(Object) = ObjectIdx; }
+	private:
+		static constexpr int32 PageBits = 10;
+		static constexpr int32 PageSize = 1 << PageBits;
+		struct FSlot
+		{
+			int32 SerialNumber;
+			FObjectIdx Value;
+		};
+		// 只清零访问标记，槽位在首次访问时写入
+		struct FPage
+		{
+			FPage() { FMemory::Memzero(VisitedMask); }
+			uint64 VisitedMask[PageSize / 64];
+			FSlot Slots[PageSize];
+		};
+		TArray<TUniquePtr<FPage>> Pages;
+	};
+
 	struct FStructToJson
 	{
+		friend struct FObjectIdxExportPolicy;
 		EPropertyFlags CheckFlags = DefaultCheckFlags;
 		EPropertyFlags SkipFlags = DefaultSkipFlags;
+		// 不为空时存在基准的对象与基准比较，其余与CDO比较
+		const FObjectBaselines* Baselines = nullptr;
 
 		FStructToJson();
 
@@ -41,11 +103,17 @@ namespace GameSerializerCore
 			AddStruct<T>(RootJsonObject, FieldName, Value);
 		}
 
-		const TSharedRef<FJsonObject>& GetResultJson() const { return RootJsonObject; }
+		// 写入对象表后返回根节点
+		const TSharedRef<FJsonObject>& GetResultJson();
+
+		// 预先记录对象储存时的归属（Actor为Owner，其余为Outer），编码时不再调用接口
+		void PrecomputeSerializedOuter(const UObject* Object, UObject* SerializedOuter) { SerializedOuterMap.Add(Object, SerializedOuter); }
 	private:
 		TSharedRef<FJsonObject> RootJsonObject = MakeShared<FJsonObject>();
-		TSharedRef<FJsonObject> ExternalJsonObject = MakeShared<FJsonObject>();
-		TSharedRef<FJsonObject> DynamicJsonObject = MakeShared<FJsonObject>();
+		// 按索引顺序紧密排列，外部对象的索引为 -(数组下标 + 1)
+		TArray<TSharedPtr<FJsonValue>> ExternalObjectsJsonArray;
+		// 按索引升序排列，索引记录在对象的__Idx字段中
+		TArray<TSharedPtr<FJsonValue>> DynamicObjectsJsonArray;
 
 		struct FOuterData
 		{
@@ -55,14 +123,20 @@ namespace GameSerializerCore
 
 			UObject* Outer;
 			const TSharedRef<FJsonObject>& OuterJsonObject;
+			TArray<TSharedPtr<FJsonValue>> SubObjectsJsonArray;
 		};
 		TArray<FOuterData> OuterChain = TArray<FOuterData>();
+		// OuterChain中的对象 -> 在OuterChain中的下标
+		TMap<const UObject*, int32> OuterChainIndexMap;
+
+		TMap<const UObject*, UObject*> SerializedOuterMap;
+		UObject* GetSerializedOuter(const UObject* Object);
 
 		FObjectIdx ObjectUniqueIdx = 0;
 		FObjectIdx ExternalObjectUniqueIdx = 0;
 
-		TMap<const UObject*, FObjectIdx> ExternalObjectIdxMap;
-		TMap<UObject*, FObjectIdx> ObjectIdxMap;
+		FObjectIndexTable ExternalObjectIdxTable;
+		FObjectIndexTable ObjectIdxTable;
 
 		FObjectIdx GetExternalObjectIndex(const UObject* ExternalObject);
 
@@ -76,12 +150,46 @@ namespace GameSerializerCore
 		void AddStruct(const TSharedRef<FJsonObject>& JsonObject, const FString& FieldName, const T& Value)
 		{
 			const static T DefaultValue{};
-			AddStruct(JsonObject, FieldName, TBaseStructure<T>::Get(), &Value, &DefaultValue);
+			if constexpr (TGameSerializerTraits<T>::bHasNativeSerializer)
+			{
+				const TSharedRef<FJsonObject> StructJsonObject = MakeShared<FJsonObject>();
+				bool bSameValue;
+				TGameSerializerTraits<T>::Encode(Value, &DefaultValue, *StructJsonObject, bSameValue);
+				if (bSameValue == false)
+				{
+					JsonObject->SetObjectField(FieldName, StructJsonObject);
+				}
+			}
+			else
+			{
+				AddStruct(JsonObject, FieldName, TBaseStructure<T>::Get(), &Value, &DefaultValue);
+			}
 		}
 	};
 
+	// 读档的扩展数据按对齐要求从整块内存中分配，由反序列化器持有
+	// 扩展数据的引用计数持有分配器，所有扩展数据释放后整块回收
+	class GAMESERIALIZER_API FExtendDataArena : public TSharedFromThis<FExtendDataArena>
+	{
+	public:
+		FExtendDataArena() = default;
+		~FExtendDataArena();
+		FExtendDataArena(const FExtendDataArena&) = delete;
+		FExtendDataArena& operator=(const FExtendDataArena&) = delete;
+
+		// 返回已初始化的扩展数据
+		TSharedRef<FGameSerializerExtendData> Allocate(const UScriptStruct* Struct);
+		SIZE_T GetAllocatedSize() const { return AllocatedSize; }
+	private:
+		static constexpr int32 BlockSize = 16 * 1024;
+		TArray<uint8*> Blocks;
+		int32 BlockOffset = BlockSize;
+		SIZE_T AllocatedSize = 0;
+	};
+
 	struct FJsonToStruct
 	{
+		friend struct FObjectIdxImportPolicy;
 		struct FSpawnedActorData
 		{
 			TWeakObjectPtr<AActor> SpawnedActor;
@@ -93,12 +201,20 @@ namespace GameSerializerCore
 		struct FInstancedObjectData
 		{
 			TWeakObjectPtr<UObject> Object;
-			TSharedRef<FJsonObject> JsonObject;
+			// CompactForPostLoad后为空
+			TSharedPtr<FJsonObject> JsonObject;
 			TArray<struct FGameSerializerNetNotifyData> AllNetNotifyData;
+			// AllNetNotifyData引用了表中的参数，加载完成前保持表有效
+			TSharedPtr<const struct FGameSerializerRepNotifyTable> RepNotifyTable;
+			// CompactForPostLoad时预先解析的扩展数据
+			const UScriptStruct* ExtendDataStruct = nullptr;
+			TSharedPtr<FGameSerializerExtendData> ExtendData;
 		};
 	public:
 		EPropertyFlags CheckFlags = DefaultCheckFlags;
 		EPropertyFlags SkipFlags = DefaultSkipFlags;
+		// 存档时的世界原点与当前世界原点的差，每个反序列化器独立，多个关卡可以同时读档
+		FIntVector WorldOffset = FIntVector::ZeroValue;
 		
 		FJsonToStruct(UObject* Outer, const TSharedRef<FJsonObject>& RootJsonObject);
 
@@ -107,18 +223,32 @@ namespace GameSerializerCore
 			LoadExternalObject();
 			InstanceDynamicObject();
 			LoadDynamicObjectJsonData();
+			RegisterPendingComponents();
 			DynamicActorFinishSpawning();
 			RestoreDynamicActorSpawnedData();
 			LoadDynamicObjectExtendData();
 		}
 		
 		void LoadExternalObject();
+		// 在后台任务中解析类型存在的动态对象数据，需要在LoadExternalObject之后调用
+		// 各关卡的反序列化器互不相关，可以同时解析，访问动态对象数据前会等待解析完成
+		void StartParseDynamicObjects();
+		bool IsParsingDynamicObjects() const { return ParseDynamicObjectsTask.IsValid() && ParseDynamicObjectsTask.IsCompleted() == false; }
 		void InstanceDynamicObject();
 		void LoadDynamicObjectJsonData();
+		// 动态创建的组件在属性读取完毕后再注册，避免按默认值创建渲染与物理状态后再被修改
+		// 流式关卡在加入世界前不注册，交由关卡加入世界时的分帧组件注册处理
+		void RegisterPendingComponents();
 		void DynamicActorFinishSpawning();
 		void RestoreDynamicActorSpawnedData();
 		void LoadDynamicObjectExtendData();
 
+		// 属性读取完成后只保留PostLoad需要的扩展数据与RepNotify，释放存档文档
+		// 之后只能执行组件注册、FinishSpawning、PostLoad以及根节点字段的读取
+		void CompactForPostLoad();
+		// 反序列化器自身持有的内存，不包括存档文档
+		SIZE_T GetAllocatedSize() const;
+
 		void RetargetDynamicObjectName(const FString& FieldName, const FName& NewName);
 
 		const TArray<FSpawnedActorData>& GetSpawnedActors() const { return SpawnedActors; }
@@ -135,7 +265,35 @@ namespace GameSerializerCore
 			return GetStruct<T>(RootJsonObject, FieldName);
 		}
 	private:
+		// 索引格式的存档在根节点记录了动态对象的名称与类型，无需解析对象本身
+		struct FDynamicObjectIndexEntry
+		{
+			FObjectIdx ObjectIdx;
+			FObjectIdx ClassIdx;
+			FString Name;
+			bool bRetargeted = false;
+		};
+		TArray<FDynamicObjectIndexEntry> DynamicObjectIndex;
+		// 解析任务持有动态对象数据的引用，只解析不修改
+		UE::Tasks::FTask ParseDynamicObjectsTask;
+		void WaitParseDynamicObjects() const;
+
+		// Outer下已存在对象的名字表，每个Outer只遍历一次，代替逐个对象的FindObject
+		struct FExistingObjects
+		{
+			TMap<FName, UObject*> Objects;
+			// 待销毁的对象需要让出名字
+			TMap<FName, UObject*> PendingKillObjects;
+		};
+		TMap<const UObject*, FExistingObjects> ExistingObjectsMap;
+		UObject* FindExistingObject(const FString& ObjectName);
+		// 通过UGameSerializerIdentityComponent的持久标识找回关卡中的Actor
+		AActor* FindActorByIdentity(const FGuid& Identity) const;
+
 		UObject* JsonObjectToInstanceObject(const TSharedRef<FJsonObject>& JsonObject, FObjectIdx ObjectIdx);
+		TSharedPtr<FGameSerializerExtendData> DecodeExtendData(const FJsonObject& JsonObject, const UScriptStruct*& OutStruct) const;
+		void InstanceSubObjects(const TSharedRef<FJsonObject>& JsonObject);
+		TSharedPtr<FJsonObject> FindDynamicObjectJson(FObjectIdx ObjectIdx) const;
 		UObject* GetObjectByIdx(FObjectIdx ObjectIdx) const;
 		bool JsonObjectIdxToObject(const TSharedPtr<FJsonValue>& JsonValue, FProperty* Property, void* OutValue) const;
 		
@@ -146,6 +304,8 @@ namespace GameSerializerCore
 
 		TArray<FSpawnedActorData> SpawnedActors;
 		TArray<FInstancedObjectData> AllInstancedObjectData;
+		TArray<TWeakObjectPtr<UActorComponent>> PendingRegisterComponents;
+		TSharedRef<FExtendDataArena> ExtendDataArena = MakeShared<FExtendDataArena>();
 
 		void GetStruct(const TSharedRef<FJsonObject>& JsonObject, const FString& FieldName, UScriptStruct* Struct, void* Value) const;
 		template<typename T>
@@ -153,11 +313,39 @@ namespace GameSerializerCore
 		{
 			static const T DefaultValue{};
 			T Value{ DefaultValue };
-			GetStruct(JsonObject, FieldName, TBaseStructure<T>::Get(), &Value);
+			if constexpr (TGameSerializerTraits<T>::bHasNativeSerializer)
+			{
+				const TSharedPtr<FJsonObject>* StructJsonObject;
+				if (JsonObject->TryGetObjectField(FieldName, StructJsonObject))
+				{
+					const bool IsLoadSucceed = TGameSerializerTraits<T>::Decode(**StructJsonObject, Value);
+					ensure(IsLoadSucceed);
+				}
+			}
+			else
+			{
+				GetStruct(JsonObject, FieldName, TBaseStructure<T>::Get(), &Value);
+			}
 			return Value;
 		}
 	};
 
 	FString JsonObjectToString(const TSharedRef<FJsonObject>& JsonObject);
 	TSharedPtr<FJsonObject> StringToJsonObject(const FString& JsonString);
+
+	// 解压后的存档数据，懒解析的动态对象引用其中的片段，需要保持存活
+	struct FJsonPayload
+	{
+		virtual ~FJsonPayload() {}
+		virtual TArrayView<const uint8> GetView() const { return Data; }
+
+		TArray<uint8> Data;
+		// 映射文件的Payload在文件被改写前会换成拷贝，使用GetView的结果期间需要持有读锁
+		mutable FRWLock ViewLock;
+	};
+
+	// 根节点后紧跟逐个编码的动态对象，根节点中记录每个动态对象的字节偏移与长度
+	TArray<uint8> EncodeJsonPayload(const TSharedRef<FJsonObject>& JsonObject);
+	// 动态对象在首次访问时才解析，兼容整体为Json文本的旧数据
+	GAMESERIALIZER_API TSharedPtr<FJsonObject> DecodeJsonPayload(const TSharedRef<const FJsonPayload>& Payload);
 }
@@ -63,8 +63,42 @@ struct FGameSerializerNetNotifyData
 {
 	FProperty* Property;
 	UFunction* RepNotifyFunc;
+	// 指向FGameSerializerRepNotifyTable中预先构造的参数，没有参数时为空
+	uint8* Params;
 };
 
+/**
+ * 类型的RepNotify属性信息，每个类型只构建一次
+ */
+struct GAMESERIALIZER_API FGameSerializerRepNotifyTable
+{
+	struct FEntry
+	{
+		UFunction* RepNotifyFunc = nullptr;
+		// 以CDO的值作为旧值构造的参数，所有实例共用
+		uint8* Params = nullptr;
+		// 在CDO的GetCallRepNotifyIgnorePropertyNames中的属性不调用RepNotify
+		bool bIgnored = false;
+	};
+
+	FGameSerializerRepNotifyTable(UClass* Class);
+	~FGameSerializerRepNotifyTable();
+	UE_NONCOPYABLE(FGameSerializerRepNotifyTable);
+
+	const FEntry* Find(const FProperty* Property) const { return Entries.Find(Property); }
+
+	TWeakObjectPtr<UClass> Class;
+private:
+	TMap<const FProperty*, FEntry> Entries;
+};
+
+namespace GameSerializerRepNotifyTable
+{
+	// 类型被重新实例化后表会被替换，持有者保证加载期间表不被释放
+	GAMESERIALIZER_API TSharedRef<const FGameSerializerRepNotifyTable> Get(UClass* Class);
+	GAMESERIALIZER_API void Flush();
+}
+
 USTRUCT(BlueprintType, BlueprintInternalUseOnly)
 struct GAMESERIALIZER_API FGameSerializerCallRepNotifyFunc
 {
@@ -83,7 +117,6 @@ struct GAMESERIALIZER_API FGameSerializerCallRepNotifyFunc
 #if DO_CHECK
 	mutable bool bCalled = false;
 #endif
-	static bool bIsGameSerializerCall;
 };
 
 UCLASS()
@@ -121,10 +154,21 @@ namespace GameSerializerExtendDataFactory
 {
 	extern GAMESERIALIZER_API TMap<UClass*, TSharedRef<FGameSerializerExtendDataFactory>> Factory;
 	
-	GAMESERIALIZER_API FGameSerializerExtendDataFactory* FindFactory(UObject* Instance);
+	// 每个类型查找的结果会被缓存，包括没有工厂的类型
+	GAMESERIALIZER_API FGameSerializerExtendDataFactory* FindFactory(const UClass* Class);
+	inline FGameSerializerExtendDataFactory* FindFactory(UObject* Instance) { return FindFactory(Instance->GetClass()); }
+	GAMESERIALIZER_API void InvalidateResolvedFactories();
 	template<typename T>
-	void RegisterFactory(UClass* Type) { Factory.Add(Type, MakeShared<T>()); }
-	inline void UnregisterFactory(UClass* Type) { Factory.Remove(Type); }
+	void RegisterFactory(UClass* Type)
+	{
+		Factory.Add(Type, MakeShared<T>());
+		InvalidateResolvedFactories();
+	}
+	inline void UnregisterFactory(UClass* Type)
+	{
+		Factory.Remove(Type);
+		InvalidateResolvedFactories();
+	}
 }
 
 USTRUCT()
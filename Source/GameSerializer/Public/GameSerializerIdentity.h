@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameSerializerIdentity.generated.h"
+
+/**
+ * Actor的持久标识，存档时记录在__Guid中
+ * 读档时优先通过标识找回关卡中的Actor，不依赖名字匹配
+ */
+UCLASS(ClassGroup = (GameSerializer), meta = (BlueprintSpawnableComponent))
+class GAMESERIALIZER_API UGameSerializerIdentityComponent : public UActorComponent
+{
+	GENERATED_BODY()
+public:
+	UGameSerializerIdentityComponent();
+
+	const FGuid& GetIdentity() const { return Identity; }
+	// 读档时还原存档中的标识
+	void SetIdentity(const FGuid& NewIdentity);
+
+	void OnComponentCreated() override;
+	void OnRegister() override;
+	void OnUnregister() override;
+#if WITH_EDITOR
+	void PostEditImport() override;
+#endif
+	void PostDuplicate(bool bDuplicateForPIE) override;
+
+	static UGameSerializerIdentityComponent* Find(const AActor* Actor);
+private:
+	UPROPERTY(VisibleAnywhere, Category = "游戏序列化")
+	FGuid Identity;
+};
+
+/**
+ * 世界中标识到Actor的索引，随组件注册与注销增量维护
+ */
+UCLASS()
+class GAMESERIALIZER_API UGameSerializerIdentitySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+public:
+	bool DoesSupportWorldType(EWorldType::Type WorldType) const override;
+
+	AActor* FindActor(const FGuid& Identity) const;
+
+	void Register(const FGuid& Identity, AActor* Actor);
+	void Unregister(const FGuid& Identity, const AActor* Actor);
+private:
+	TMap<FGuid, TWeakObjectPtr<AActor>> IdentityIndex;
+};
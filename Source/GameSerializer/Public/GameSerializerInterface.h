@@ -81,7 +81,9 @@ public:
 	UFUNCTION(BlueprintNativeEvent, Category = "游戏序列化")
 	bool CanGameSerializedInLevel() const;
 	virtual bool CanGameSerializedInLevel_Implementation() const;
-	static bool CanGameSerializedInLevel(const AActor* Actor) { return Execute_CanGameSerializedInLevel(Actor); }
+	static bool CanGameSerializedInLevel(const AActor* Actor);
+	// 实现了接口且可以储存在关卡中，未实现接口的类型只需一次查表
+	static bool IsGameSerializedInLevel(const AActor* Actor);
 
 	UFUNCTION(BlueprintNativeEvent, Category = "游戏序列化")
 	AActor* GetGameSerializedOwner() const;
@@ -96,5 +98,5 @@ public:
 	UFUNCTION(BlueprintNativeEvent, Category = "游戏序列化")
 	int32 GetGameSerializePriority() const;
 	virtual int32 GetGameSerializePriority_Implementation() const { return 0; }
-	static int32 GetGameSerializePriority(const AActor* Actor) { return Execute_GetGameSerializePriority(Actor); }
+	static int32 GetGameSerializePriority(const AActor* Actor);
 };
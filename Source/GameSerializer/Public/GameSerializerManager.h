@@ -5,8 +5,22 @@
 #include "CoreMinimal.h"
 #include "Subsystems/GameInstanceSubsystem.h"
 #include "Components/ActorComponent.h"
+#include "Containers/Ticker.h"
+#include "Tasks/Task.h"
 #include "GameSerializerManager.generated.h"
 
+namespace GameSerializerStorage
+{
+	class FSaveSlotContainer;
+	class FPayloadCache;
+}
+
+namespace GameSerializerCore
+{
+	class FObjectBaselines;
+	struct FJsonPayload;
+}
+
 // Level层级的数据和事件
 UCLASS()
 class UGameSerializerLevelComponent : public UActorComponent
@@ -35,13 +49,14 @@ public:
 	void WhenLevelLoaded();
 };
 
+// 已废弃，流式关卡改为通过FLevelStreamingDelegates的状态变化注册，不再创建该子系统
+// 保留类型以兼容已有的引用，之后的版本移除
 UCLASS()
 class UGameSerializerWorldSubsystem : public UWorldSubsystem
 {
 	GENERATED_BODY()
 public:
-	bool DoesSupportWorldType(EWorldType::Type WorldType) const override;
-	void UpdateStreamingState() override;
+	bool ShouldCreateSubsystem(UObject* Outer) const override;
 };
 
 /**
@@ -51,8 +66,6 @@ UCLASS()
 class GAMESERIALIZER_API UGameSerializerManager : public UGameInstanceSubsystem
 {
 	GENERATED_BODY()
-
-	friend class UGameSerializerWorldSubsystem;
 public:
 	UGameSerializerManager();
 	
@@ -72,6 +85,13 @@ protected:
 
 	int32 UserIndex = 0;
 
+	// 未启用存档容器或打开失败时为空
+	TSharedPtr<GameSerializerStorage::FSaveSlotContainer> GetSlotContainer();
+	// 未启用存档缓存时为空
+	TSharedPtr<GameSerializerStorage::FPayloadCache> GetPayloadCache();
+	// 等待后台写入全部完成
+	void FlushPendingWrites();
+
 	void InitActorAndComponents(AActor* Actor);
 	void LoadOrInitLevel(ULevel* Level);
 	void LoadOrInitWorld(UWorld* World);
@@ -99,6 +119,8 @@ public:
 	FOnLevelPreSaveNative OnLevelPreSaveNative;
 private:
 	FDelegateHandle OnLevelAdd_DelegateHandle;
+	FDelegateHandle OnPreLevelRemoved_DelegateHandle;
+	FDelegateHandle OnLevelStreamingStateChanged_DelegateHandle;
 	FDelegateHandle OnWorldCleanup_DelegateHandle;
 	FDelegateHandle OnGameModeInitialized_DelegateHandle;
 #if WITH_EDITORONLY_DATA
@@ -106,15 +128,67 @@ private:
 #endif
 	uint8 bIsEnable : 1;
 	uint8 bInvokeLoadGame : 1;
-	uint8 bShouldInitSpawnActor : 1;
+
+	// 读档期间Spawn的Actor不需要初始化，作用域可以嵌套
+	int32 SkipInitSpawnActorCounter = 0;
+	struct FScopedSkipInitSpawnActor
+	{
+		FScopedSkipInitSpawnActor(UGameSerializerManager& InManager, bool bInSkip = true);
+		~FScopedSkipInitSpawnActor();
+	private:
+		UGameSerializerManager& Manager;
+		bool bSkip;
+	};
+
+	TSharedPtr<GameSerializerStorage::FSaveSlotContainer> SlotContainer;
+	bool bSlotContainerOpenFailed = false;
+	// (存档路径, 用户) -> 最近一次读取或储存的Payload的哈希
+	TMap<TPair<FString, int32>, uint64> SavedContentHashes;
+
+	TSharedPtr<GameSerializerStorage::FPayloadCache> PayloadCache;
+	// 启用存档缓存时存档在后台按储存顺序压缩，写入存档容器
+	UE::Tasks::FTask PendingWriteTask;
+	// 未使用存档容器时通过平台存档系统的SaveGameAsync写入，同一存档同时只有一个写入
+	struct FSaveGameWrite
+	{
+		bool bInFlight = false;
+		TSharedPtr<const TArray<uint8>> QueuedFileData;
+		TSharedPtr<const GameSerializerCore::FJsonPayload> QueuedPayload;
+		uint64 QueuedContentHash = 0;
+	};
+	TMap<TPair<FString, int32>, FSaveGameWrite> SaveGameWrites;
+	// 已储存但平台存档系统还未完成写入的数量
+	int32 PendingSaveGameNum = 0;
+	void WriteSaveGameAsync(int32 SaveUserIndex, const FString& FilePath, const TSharedRef<const TArray<uint8>>& FileData, const TSharedRef<const GameSerializerCore::FJsonPayload>& Payload, uint64 ContentHash);
+	void WhenSaveGameWritten(int32 SaveUserIndex, const FString& FilePath, const TSharedRef<const GameSerializerCore::FJsonPayload>& Payload, uint64 ContentHash, bool bSaved);
+	void WhenPayloadWritten(int32 SaveUserIndex, const FString& FilePath, uint64 ContentHash, const TSharedRef<const GameSerializerCore::FJsonPayload>& Payload, bool bSaved);
 
 	TWeakObjectPtr<UWorld> LoadedWorld;
 	TArray<TWeakObjectPtr<ULevel>> LoadedLevels;
 
-	void UpdateLevelStreamingData();
+	// 流式关卡在载入完成时读档，注册表通过流式关卡的状态变化维护，不需要每帧遍历
+	void RegisterLevelStreaming(ULevelStreaming* LevelStreaming);
+	// 解除在ULevelStreaming上的绑定，关卡移除后再次加入时重新注册
+	void UnregisterLevelStreaming(ULevelStreaming* LevelStreaming);
+	void ResetLevelStreamingLambdas();
+	void WhenStreamingLevelLoaded(ULevel* LoadedLevel);
+
+	// 等待读档的流式关卡，按优先级在每帧的预算内分阶段执行
+	TArray<TSharedRef<struct FPendingLevelLoad>> PendingLevelLoads;
+	FTSTicker::FDelegateHandle LevelLoadTickerHandle;
+	bool TickLevelLoads(float DeltaTime);
+	// 返回true时该关卡的读档结束
+	bool StepLevelLoad(FPendingLevelLoad& LevelLoad);
+	// 关卡加入世界时立即完成剩余的阶段
+	void FinishPendingLevelLoad(ULevel* Level);
+	void ResetPendingLevelLoads();
 	TMap<TWeakObjectPtr<ULevel>, TSharedRef<struct FLevelDeserializer>> StreamLoadedLevelDataMap;
+
+	// 关卡载入后读档前记录预放置对象的状态，储存关卡时只写入与之不同的数据
+	void CaptureLevelBaselines(ULevel* Level);
+	TMap<TWeakObjectPtr<ULevel>, TSharedRef<GameSerializerCore::FObjectBaselines>> LevelBaselinesMap;
 	UPROPERTY(Transient)
-	TArray<UGameSerializerLevelStreamingLambda*> CachedLevelStreamingLambdas;
+	TMap<ULevelStreaming*, UGameSerializerLevelStreamingLambda*> LevelStreamingLambdas;
 
 	static FString GetLevelPath(const ULevel* Level);
 public:
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "GameSerializerSettings.generated.h"
+
+UENUM()
+enum class EGameSerializerSaveCodec : uint8
+{
+	// 整体Zlib压缩
+	Zlib,
+	// 分块Zlib压缩，可以直接从映射的文件解压
+	BlockZlib,
+	// 不压缩，映射读取时无需任何拷贝
+	None
+};
+
+/**
+ * 
+ */
+UCLASS(Config = Game, DefaultConfig, meta = (DisplayName = "游戏序列化"))
+class GAMESERIALIZER_API UGameSerializerSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+public:
+	UGameSerializerSettings();
+
+	// 存档文件的压缩方式
+	UPROPERTY(Config, EditAnywhere, Category = "存储")
+	EGameSerializerSaveCodec SaveCodec = EGameSerializerSaveCodec::Zlib;
+
+	UPROPERTY(Config, EditAnywhere, Category = "存储", meta = (EditCondition = "SaveCodec == EGameSerializerSaveCodec::BlockZlib", ClampMin = 4096))
+	int32 CompressionBlockSize = 256 * 1024;
+
+	// 直接映射SaveGames目录下的存档文件进行读取，需要平台存档系统使用默认的文件储存方式
+	UPROPERTY(Config, EditAnywhere, Category = "存储")
+	bool bUseMappedFileReads = false;
+
+	// 将关卡与玩家的存档储存在同一个容器文件中，通过内存中的目录查找存档
+	// 第一次打开容器时导入SaveGames目录下原有的单独存档文件，之后只通过目录查找，原文件保留不变
+	UPROPERTY(Config, EditAnywhere, Category = "存储")
+	bool bUseSlotContainer = false;
+
+	UPROPERTY(Config, EditAnywhere, Category = "存储", meta = (EditCondition = "bUseSlotContainer"))
+	FString SlotContainerName = TEXT("GameSerializer");
+
+	// 容器中废弃数据的占比超过该值时重写容器
+	UPROPERTY(Config, EditAnywhere, Category = "存储", meta = (EditCondition = "bUseSlotContainer", ClampMin = 0.1, ClampMax = 1.0))
+	float SlotCompactDeadRatio = 0.5f;
+
+	// 在内存中缓存最近读取或储存的存档，流式关卡重新加载时直接从内存读取，为0时关闭
+	// 开启后存档在后台压缩，通过平台存档系统的SaveGameAsync（或存档容器）写入，未写入的存档不受容量限制
+	UPROPERTY(Config, EditAnywhere, Category = "存储", meta = (ClampMin = 0, Units = "Megabytes"))
+	int32 PayloadCacheSizeMB = 0;
+
+	// 使用结构体原生的Serialize储存为二进制数据，代替ExportTextItem导出的文本，同时记录引擎与自定义版本
+	// 只有NetSerialize的结构体不支持，会给出警告
+	// 读档时两种格式都可以读取，移出列表不影响旧存档
+	UPROPERTY(Config, EditAnywhere, Category = "序列化")
+	TArray<TSoftObjectPtr<UScriptStruct>> BinarySerializeStructs;
+
+	// 流式关卡卸载时回收动态生成的Actor，读档时复用，减少Spawn与Destroy
+	UPROPERTY(Config, EditAnywhere, Category = "对象池")
+	bool bUseActorPool = false;
+
+	// 可以回收的类型，包括子类，不支持复制的类型
+	// 非SaveGame的对象引用在复用时不会恢复为默认值，见UGameSerializerActorPool
+	UPROPERTY(Config, EditAnywhere, Category = "对象池", meta = (EditCondition = "bUseActorPool"))
+	TArray<TSoftClassPtr<AActor>> PooledActorClasses;
+
+	UPROPERTY(Config, EditAnywhere, Category = "对象池", meta = (EditCondition = "bUseActorPool", ClampMin = 1))
+	int32 ActorPoolMaxPerClass = 64;
+
+	// 流式关卡载入后按与玩家视点的距离排序，分帧读档，每帧最多占用的时间，为0时载入后立即读档
+	// 分帧只在关卡不可见期间进行，关卡开始加入世界时尚未完成的读档会立即完成
+	UPROPERTY(Config, EditAnywhere, Category = "加载调度", meta = (ClampMin = 0, Units = "Milliseconds"))
+	float LevelLoadBudgetMs = 0.f;
+
+	bool IsBinarySerializeStruct(const UScriptStruct* Struct) const;
+
+	void PostReloadConfig(FProperty* PropertyThatWasLoaded) override;
+#if WITH_EDITOR
+	void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+private:
+	mutable TSet<const UScriptStruct*> BinarySerializeStructSet;
+	mutable bool bBinarySerializeStructSetDirty = true;
+};
@@ -0,0 +1,142 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameSerializerCore.h"
+
+enum class EGameSerializerSaveCodec : uint8;
+class IFileHandle;
+
+/**
+ * 存档文件的编码与读取
+ */
+namespace GameSerializerStorage
+{
+	// Payload为GameSerializerCore::EncodeJsonPayload的结果
+	TArray<uint8> EncodeSaveFile(TArrayView<const uint8> Payload, EGameSerializerSaveCodec Codec, int32 BlockSize);
+
+	// 解码从SaveGameSystem读取的数据，未压缩时直接引用FileData
+	TSharedPtr<GameSerializerCore::FJsonPayload> DecodeSaveFile(TArray<uint8>&& FileData);
+	// 映射文件后解码，未压缩时直接引用映射的内存，压缩的数据直接从映射的内存解压
+	GAMESERIALIZER_API TSharedPtr<GameSerializerCore::FJsonPayload> DecodeMappedSaveFile(const FString& FilePath);
+	// 改写存档文件前调用，仍引用该文件映射的Payload（缓存或反序列化器持有）换成拷贝并关闭映射
+	GAMESERIALIZER_API void ReleaseMappedSaveFile(const FString& FilePath);
+
+	// 默认SaveGameSystem储存存档的文件路径
+	GAMESERIALIZER_API FString GetSaveGameFilePath(const FString& Name);
+
+	/**
+	 * 最近读取或储存的存档Payload的LRU缓存，流式关卡反复加载卸载时不再经过磁盘读取与解压
+	 * 超出内存预算时淘汰最久未使用的条目，尚未写入磁盘的条目不会被淘汰
+	 * 以存档路径与用户为键，与平台存档系统一致
+	 */
+	class GAMESERIALIZER_API FPayloadCache
+	{
+	public:
+		using FKey = TPair<FString, int32>;
+
+		void SetBudget(int64 InBudgetBytes);
+
+		TSharedPtr<const GameSerializerCore::FJsonPayload> Find(const FKey& Key);
+		void Add(const FKey& Key, const TSharedRef<const GameSerializerCore::FJsonPayload>& Payload, bool bPendingWrite);
+		// 写入完成后条目可以被淘汰，Payload已被新的储存替换时忽略
+		void MarkWritten(const FKey& Key, const TSharedRef<const GameSerializerCore::FJsonPayload>& Payload);
+		void Empty();
+
+		int64 GetMemoryBytes() const { return MemoryBytes; }
+		uint32 GetHitNum() const { return HitNum; }
+		uint32 GetMissNum() const { return MissNum; }
+	private:
+		struct FEntry
+		{
+			TSharedRef<const GameSerializerCore::FJsonPayload> Payload;
+			int64 Size;
+			uint64 LastUsed;
+			bool bPendingWrite;
+		};
+		TMap<FKey, FEntry> Entries;
+		int64 BudgetBytes = 0;
+		int64 MemoryBytes = 0;
+		uint64 UseCounter = 0;
+		uint32 HitNum = 0;
+		uint32 MissNum = 0;
+
+		void Remove(const FKey& Key);
+		void Evict();
+		void UpdateMemoryStat() const;
+	};
+
+	/**
+	 * 将一个存档槽的所有存档文件储存在同一个容器文件中
+	 * 文件结构为 [文件头][条目数据...][目录]，更新条目时在末尾追加数据和新的目录，最后改写文件头
+	 * 被覆盖的条目与旧目录成为废弃数据，占比超过阈值时重写整个容器
+	 * 容器在两个文件间交替重写，打开时读取文件头中代数较大的，每次打开后第一次写入前也会重写一次
+	 * 后台写入与游戏线程读取可以同时进行，所有操作互斥
+	 */
+	class GAMESERIALIZER_API FSaveSlotContainer
+	{
+	public:
+		static TSharedPtr<FSaveSlotContainer> Open(const FString& FilePath, float CompactDeadRatio);
+
+		FSaveSlotContainer(const FString& InFilePath, float InCompactDeadRatio);
+		~FSaveSlotContainer();
+
+		bool Contains(const FString& Name) const { FScopeLock Lock(&CriticalSection); return Toc.Contains(Name); }
+		TSharedPtr<GameSerializerCore::FJsonPayload> Read(const FString& Name);
+		// FileData为EncodeSaveFile的结果
+		bool Write(const FString& Name, TArrayView<const uint8> FileData, EGameSerializerSaveCodec Codec);
+
+		// 批量写入期间只追加条目数据，目录在最外层批量写入结束时写入一次
+		struct GAMESERIALIZER_API FScopedBatch
+		{
+			FScopedBatch(const TSharedPtr<FSaveSlotContainer>& InContainer);
+			~FScopedBatch();
+		private:
+			TSharedPtr<FSaveSlotContainer> Container;
+		};
+
+		void Commit();
+		void Compact();
+		int64 GetDeadBytes() const;
+
+		// 导入完成后目录中没有的存档不需要再查找单独的存档文件
+		bool IsLegacyImported() const;
+		// 一次性导入启用容器前各分类目录下的单独存档文件，原文件保留不变
+		void ImportLegacySaveFiles(const TArray<FString>& Categories);
+	private:
+		struct FEntry
+		{
+			int64 Offset;
+			int64 Size;
+			uint8 Codec;
+			uint64 Hash;
+		};
+
+		FString FilePath;
+		// 当前读写的文件，重写前为只读
+		TUniquePtr<IFileHandle> FileHandle;
+		int32 ActiveFileIdx = 0;
+		uint64 Generation = 0;
+		TMap<FString, FEntry> Toc;
+		// 有效数据的末尾，之后的内容为中断的写入，会被覆盖
+		int64 FileSize = 0;
+		int64 HeaderSize = 0;
+		int64 TocSize = 0;
+		int64 LiveBytes = 0;
+		float CompactDeadRatio;
+		int32 BatchDepth = 0;
+		bool bTocDirty = false;
+		bool bWritable = false;
+		mutable FCriticalSection CriticalSection;
+
+		FString GetFilePath(int32 FileIdx) const;
+		bool LoadLatest();
+		bool BeginWrite();
+		// 将有效条目写入另一个文件，成功后切换到该文件
+		bool Rewrite(int32 TargetFileIdx);
+		bool LoadToc();
+		bool WriteToc();
+		static bool WriteToc(IFileHandle& Handle, const TMap<FString, FEntry>& InToc, int64 TocOffset, uint64 InGeneration, int64& OutTocSize);
+	};
+}
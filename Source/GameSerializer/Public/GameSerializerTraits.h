@@ -0,0 +1,263 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <Dom/JsonObject.h>
+#include <Dom/JsonValue.h>
+#include <Templates/Tuple.h>
+#include <type_traits>
+
+/**
+ * 原生结构体的序列化特化点，默认走反射
+ * 特化后AddStruct<T>、GetStruct<T>以及通过GameSerializerNativeStruct::Register<T>注册过的结构体属性不再经过反射
+ * 导出格式与反射保持一致（属性名为键，与默认值相同的字段不写入），两种方式的存档可以互相读取
+ *
+ * 手写编解码：
+ *	template<> struct TGameSerializerTraits<FMyStats>
+ *	{
+ *		static constexpr bool bHasNativeSerializer = true;
+ *		static void Encode(const FMyStats& Value, const FMyStats* DefaultValue, FJsonObject& Out, bool& bSameValue);
+ *		static bool Decode(const FJsonObject& In, FMyStats& Value);
+ *	};
+ *
+ * 字段列表：
+ *	template<> struct TGameSerializerTraits<FMyStats> : TGameSerializerFieldListTraits<FMyStats>
+ *	{
+ *		static inline const auto Fields = MakeTuple(GameSerializerField(TEXT("Health"), &FMyStats::Health), GameSerializerField(TEXT("Level"), &FMyStats::Level));
+ *	};
+ */
+template<typename T>
+struct TGameSerializerTraits
+{
+	static constexpr bool bHasNativeSerializer = false;
+};
+
+template<typename TStruct, typename TMember>
+struct TGameSerializerField
+{
+	const TCHAR* Name;
+	TMember TStruct::* Member;
+};
+
+template<typename TStruct, typename TMember>
+constexpr TGameSerializerField<TStruct, TMember> GameSerializerField(const TCHAR* Name, TMember TStruct::* Member)
+{
+	return TGameSerializerField<TStruct, TMember>{ Name, Member };
+}
+
+namespace GameSerializerTraitsPrivate
+{
+	// 字段只支持数值、布尔、枚举（需为UENUM）、字符串、FName、特化过的结构体以及它们的数组，对象引用需走反射
+	template<typename TValue>
+	TSharedPtr<FJsonValue> EncodeFieldValue(const TValue& Value, const TValue* DefaultValue, bool& bSameValue)
+	{
+		if constexpr (TIsTArray<TValue>::Value)
+		{
+			using FElementType = typename TValue::ElementType;
+			bSameValue = DefaultValue && DefaultValue->Num() == Value.Num();
+			TArray<TSharedPtr<FJsonValue>> Out;
+			Out.Reserve(Value.Num());
+			for (int32 Idx = 0; Idx < Value.Num(); ++Idx)
+			{
+				bool bElementSameValue;
+				Out.Add(EncodeFieldValue<FElementType>(Value[Idx], DefaultValue && DefaultValue->IsValidIndex(Idx) ? &(*DefaultValue)[Idx] : nullptr, bElementSameValue));
+				bSameValue &= bElementSameValue;
+			}
+			return MakeShared<FJsonValueArray>(Out);
+		}
+		else if constexpr (TGameSerializerTraits<TValue>::bHasNativeSerializer)
+		{
+			const TSharedRef<FJsonObject> Out = MakeShared<FJsonObject>();
+			TGameSerializerTraits<TValue>::Encode(Value, DefaultValue, *Out, bSameValue);
+			return MakeShared<FJsonValueObject>(Out);
+		}
+		else
+		{
+			bSameValue = DefaultValue && Value == *DefaultValue;
+			if constexpr (std::is_same_v<TValue, bool>)
+			{
+				return MakeShared<FJsonValueBoolean>(Value);
+			}
+			else if constexpr (std::is_enum_v<TValue>)
+			{
+				return MakeShared<FJsonValueString>(StaticEnum<TValue>()->GetNameStringByValue(static_cast<int64>(Value)));
+			}
+			else if constexpr (std::is_arithmetic_v<TValue>)
+			{
+				return MakeShared<FJsonValueNumber>(static_cast<double>(Value));
+			}
+			else if constexpr (std::is_same_v<TValue, FString>)
+			{
+				return MakeShared<FJsonValueString>(Value);
+			}
+			else if constexpr (std::is_same_v<TValue, FName>)
+			{
+				return MakeShared<FJsonValueString>(Value.ToString());
+			}
+			else
+			{
+				static_assert(sizeof(TValue) == 0, "TGameSerializerTraits: unsupported field type.");
+				return nullptr;
+			}
+		}
+	}
+
+	template<typename TValue>
+	bool DecodeFieldValue(const FJsonValue& JsonValue, TValue& Value)
+	{
+		if constexpr (TIsTArray<TValue>::Value)
+		{
+			const TArray<TSharedPtr<FJsonValue>>* JsonArray;
+			if (JsonValue.TryGetArray(JsonArray) == false)
+			{
+				return false;
+			}
+			Value.SetNum(JsonArray->Num());
+			for (int32 Idx = 0; Idx < JsonArray->Num(); ++Idx)
+			{
+				if (DecodeFieldValue(*(*JsonArray)[Idx], Value[Idx]) == false)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+		else if constexpr (TGameSerializerTraits<TValue>::bHasNativeSerializer)
+		{
+			const TSharedPtr<FJsonObject>* JsonObject;
+			return JsonValue.TryGetObject(JsonObject) && TGameSerializerTraits<TValue>::Decode(**JsonObject, Value);
+		}
+		else if constexpr (std::is_same_v<TValue, bool>)
+		{
+			return JsonValue.TryGetBool(Value);
+		}
+		else if constexpr (std::is_enum_v<TValue>)
+		{
+			FString EnumName;
+			if (JsonValue.TryGetString(EnumName))
+			{
+				const int64 EnumValue = StaticEnum<TValue>()->GetValueByNameString(EnumName);
+				if (EnumValue == INDEX_NONE)
+				{
+					return false;
+				}
+				Value = static_cast<TValue>(EnumValue);
+				return true;
+			}
+			double Number;
+			if (JsonValue.TryGetNumber(Number))
+			{
+				Value = static_cast<TValue>(static_cast<int64>(Number));
+				return true;
+			}
+			return false;
+		}
+		else if constexpr (std::is_arithmetic_v<TValue>)
+		{
+			double Number;
+			if (JsonValue.TryGetNumber(Number))
+			{
+				Value = static_cast<TValue>(Number);
+				return true;
+			}
+			return false;
+		}
+		else if constexpr (std::is_same_v<TValue, FString>)
+		{
+			return JsonValue.TryGetString(Value);
+		}
+		else if constexpr (std::is_same_v<TValue, FName>)
+		{
+			FString NameString;
+			if (JsonValue.TryGetString(NameString))
+			{
+				Value = FName(*NameString);
+				return true;
+			}
+			return false;
+		}
+		else
+		{
+			static_assert(sizeof(TValue) == 0, "TGameSerializerTraits: unsupported field type.");
+			return false;
+		}
+	}
+}
+
+/**
+ * 由特化提供的Fields生成编解码
+ */
+template<typename T>
+struct TGameSerializerFieldListTraits
+{
+	static constexpr bool bHasNativeSerializer = true;
+
+	static void Encode(const T& Value, const T* DefaultValue, FJsonObject& Out, bool& bSameValue)
+	{
+		bSameValue = true;
+		VisitTupleElements([&](const auto& Field)
+		{
+			bool bFieldSameValue;
+			const TSharedPtr<FJsonValue> JsonValue = GameSerializerTraitsPrivate::EncodeFieldValue(Value.*Field.Member, DefaultValue ? &(DefaultValue->*Field.Member) : nullptr, bFieldSameValue);
+			bSameValue &= bFieldSameValue;
+			if (bFieldSameValue == false)
+			{
+				Out.SetField(Field.Name, JsonValue);
+			}
+		}, TGameSerializerTraits<T>::Fields);
+	}
+
+	static bool Decode(const FJsonObject& In, T& Value)
+	{
+		bool bSucceed = true;
+		VisitTupleElements([&](const auto& Field)
+		{
+			// 未写入的字段与默认值相同，保持不变
+			if (const TSharedPtr<FJsonValue>* JsonValue = In.Values.Find(Field.Name))
+			{
+				bSucceed &= GameSerializerTraitsPrivate::DecodeFieldValue(**JsonValue, Value.*Field.Member);
+			}
+		}, TGameSerializerTraits<T>::Fields);
+		return bSucceed;
+	}
+};
+
+/**
+ * 结构体属性在反射遍历中按UScriptStruct查找原生序列化
+ */
+struct FGameSerializerNativeStruct
+{
+	// DefaultValue为空时写入所有字段
+	void (*Encode)(const void* Value, const void* DefaultValue, FJsonObject& Out, bool& bSameValue);
+	bool (*Decode)(const FJsonObject& In, void* Value);
+};
+
+namespace GameSerializerNativeStruct
+{
+	GAMESERIALIZER_API void Register(const UScriptStruct* Struct, const FGameSerializerNativeStruct& NativeStruct);
+	GAMESERIALIZER_API void Unregister(const UScriptStruct* Struct);
+	GAMESERIALIZER_API const FGameSerializerNativeStruct* Find(const UScriptStruct* Struct);
+
+	// 需要在模块启动后注册，StaticStruct在静态初始化阶段不可用
+	template<typename T>
+	void Register()
+	{
+		static_assert(TGameSerializerTraits<T>::bHasNativeSerializer, "TGameSerializerTraits<T> must be specialized.");
+		FGameSerializerNativeStruct NativeStruct;
+		NativeStruct.Encode = [](const void* Value, const void* DefaultValue, FJsonObject& Out, bool& bSameValue)
+		{
+			TGameSerializerTraits<T>::Encode(*static_cast<const T*>(Value), static_cast<const T*>(DefaultValue), Out, bSameValue);
+		};
+		NativeStruct.Decode = [](const FJsonObject& In, void* Value)
+		{
+			return TGameSerializerTraits<T>::Decode(In, *static_cast<T*>(Value));
+		};
+		Register(TBaseStructure<T>::Get(), NativeStruct);
+	}
+	template<typename T>
+	void Unregister()
+	{
+		Unregister(TBaseStructure<T>::Get());
+	}
+}